@@ -1,26 +1,64 @@
 #version 330 core
 
-layout (location = 0) in vec3 a_Vertex;
-layout (location = 1) in vec3 a_UV;
-layout (location = 2) in vec3 a_Normal;
-layout (location = 3) in uint a_Color;
-// layout (location = 4) in vec3 a_Pos;
+/*
+	a_Data = (binary, lowest bit on the right)
+		llllllll fff zzzzz yyyyy xxxxx
+	x, y, z => the corner of the block, relative to the chunk (0 to 16)
+	f       => the face, in the same order as phx::gfx::BlockFace
+	l       => the layer of the texture array to sample
+*/
+layout (location = 0) in uint a_Data;
+layout (location = 1) in uint a_Color;
 
 uniform mat4 u_model;
 uniform mat4 u_view;
 uniform mat4 u_projection;
 
+// the position of the chunk each vertex belongs to, in blocks. Chunks
+// are drawn from one large buffer, split into granules of 64 vertices that
+// each belong to a single chunk - see ChunkRenderer.
+uniform isamplerBuffer u_chunkOrigins;
+
 out vec3 pass_UV;
 out vec3 pass_normal;
 flat out uint pass_color;
-// out vec3 pass_pos;
+
+// front, left, back, right, top, bottom.
+const vec3 NORMALS[6] = vec3[6](
+	vec3(0.0, 0.0, -1.0),
+	vec3(-1.0, 0.0, 0.0),
+	vec3(0.0, 0.0, 1.0),
+	vec3(1.0, 0.0, 0.0),
+	vec3(0.0, 1.0, 0.0),
+	vec3(0.0, -1.0, 0.0)
+);
 
 void main()
 {
-	gl_Position = u_projection * u_view * u_model * vec4(a_Vertex, 1.f); // don't need model right now either.
+	vec3 local = vec3(
+		float(a_Data & 31u),
+		float((a_Data >> 5) & 31u),
+		float((a_Data >> 10) & 31u)
+	);
+	uint face = (a_Data >> 15) & 7u;
+	float layer = float((a_Data >> 18) & 255u);
+
+	// blocks are 2 units wide and centered on (block * 2).
+	vec3 origin = vec3(texelFetch(u_chunkOrigins, gl_VertexID / 64).xyz);
+	vec3 position = (origin + local) * 2.0 - 1.0;
+	gl_Position = u_projection * u_view * u_model * vec4(position, 1.0);
+
+	// the texture repeats once per block, so the UVs are just the position
+	// across the face - merged faces tile rather than stretch.
+	vec2 uv;
+	if (face == 0u)      uv = vec2(-local.x, -local.y);
+	else if (face == 1u) uv = vec2(local.z, -local.y);
+	else if (face == 2u) uv = vec2(local.x, -local.y);
+	else if (face == 3u) uv = vec2(-local.z, -local.y);
+	else if (face == 4u) uv = vec2(local.x, local.z);
+	else                 uv = vec2(local.x, -local.z);
 
-	pass_UV = a_UV;
-	pass_normal = a_Normal;
+	pass_UV = vec3(uv, layer);
+	pass_normal = NORMALS[int(face)];
 	pass_color = a_Color;
-	// pass_pos = a_Pos;
 }
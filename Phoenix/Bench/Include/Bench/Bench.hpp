@@ -0,0 +1,176 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file Bench.hpp
+ * @brief A small harness for timing the engine's hot paths.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phx::bench
+{
+	/**
+	 * @brief A list of named benchmark cases.
+	 *
+	 * Each part of the engine has a register function (declared below)
+	 * which adds its cases, main calls all of them and then runs whichever
+	 * cases were asked for, in the order they were added.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Suite suite;
+	 * suite.add("storage", [] {
+	 *     const auto time = measure([] { doSomething(); });
+	 *     report("something", perSecond(1, time), "per second");
+	 * });
+	 *
+	 * suite.run("stor"); // runs every case with "stor" in its name.
+	 * @endcode
+	 */
+	class Suite
+	{
+	public:
+		/// @brief A benchmark, which prints its own results with report().
+		using Case = std::function<void()>;
+
+		/**
+		 * @brief Adds a case to the suite.
+		 * @param name The name of the case, used to filter what's run.
+		 * @param run The function running the case.
+		 */
+		void add(const std::string& name, Case run);
+
+		/**
+		 * @brief Runs every case whose name contains the filter.
+		 * @param filter The text to look for, empty runs everything.
+		 * @return How many cases were run.
+		 */
+		std::size_t run(const std::string& filter) const;
+
+		/// @brief Prints the name of every case.
+		void list() const;
+
+	private:
+		std::vector<std::pair<std::string, Case>> m_cases;
+	};
+
+	/**
+	 * @brief Times a function, keeping the fastest of a few runs.
+	 * @param function The function to time.
+	 * @param runs How many times to run it.
+	 * @return The time the fastest run took.
+	 *
+	 * The fastest run is the one least disturbed by everything else going
+	 * on, so it's the most repeatable between runs of the benchmark.
+	 */
+	template <typename Function>
+	std::chrono::nanoseconds measure(Function&& function, int runs = 5)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		auto best = std::chrono::nanoseconds::max();
+		for (int i = 0; i < runs; ++i)
+		{
+			const Clock::time_point start = Clock::now();
+			function();
+			best = std::min(best, std::chrono::duration_cast<
+			                          std::chrono::nanoseconds>(
+			                          Clock::now() - start));
+		}
+
+		return best;
+	}
+
+	/**
+	 * @brief Gets how many of something happen per second.
+	 * @param count How many were done.
+	 * @param time How long doing them took.
+	 * @return The amount done per second.
+	 */
+	double perSecond(double count, std::chrono::nanoseconds time);
+
+	/**
+	 * @brief Prints a single result of a case.
+	 * @param what What was measured.
+	 * @param value The measurement.
+	 * @param unit The unit of the measurement.
+	 */
+	void report(const std::string& what, double value,
+	            const std::string& unit);
+
+	/**
+	 * @brief Keeps a result alive, so the work producing it isn't
+	 * optimised away.
+	 * @param value The result to keep.
+	 */
+	void keep(std::size_t value);
+
+	/**
+	 * @brief Gets a block by its unique ID, registering it if it's not
+	 * been registered yet.
+	 * @param id The unique ID of the block.
+	 * @param solid Whether the block is solid or air.
+	 * @return The registry ID of the block.
+	 *
+	 * The benchmark doesn't load any mods, so cases register the blocks
+	 * they need themselves through this.
+	 */
+	std::size_t getBlock(const std::string& id, bool solid = true);
+
+	/// @brief Adds the cases for chunk block storage.
+	void registerStorageCases(Suite& suite);
+
+	/// @brief Adds the cases for block coordinates and block lookups.
+	void registerCoordinateCases(Suite& suite);
+
+	/// @brief Adds the cases for saving chunks to region files.
+	void registerRegionCases(Suite& suite);
+
+	/// @brief Adds the cases for looking blocks up in the registry.
+	void registerRegistryCases(Suite& suite);
+
+	/// @brief Adds the cases for meshing chunks.
+	void registerMeshingCases(Suite& suite);
+
+	/// @brief Adds the cases for keeping track of the chunks in view.
+	void registerViewCases(Suite& suite);
+
+	/// @brief Adds the cases for generating terrain.
+	void registerGenerationCases(Suite& suite);
+} // namespace phx::bench
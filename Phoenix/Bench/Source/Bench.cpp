@@ -0,0 +1,107 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Voxels/BlockRegistry.hpp>
+
+#include <cstdio>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	volatile std::size_t g_sink = 0;
+} // namespace
+
+void Suite::add(const std::string& name, Case run)
+{
+	m_cases.emplace_back(name, std::move(run));
+}
+
+std::size_t Suite::run(const std::string& filter) const
+{
+	std::size_t ran = 0;
+	for (const auto& [name, run] : m_cases)
+	{
+		if (name.find(filter) == std::string::npos)
+			continue;
+
+		std::printf("%s\n", name.c_str());
+		std::fflush(stdout);
+
+		run();
+		++ran;
+	}
+
+	return ran;
+}
+
+void Suite::list() const
+{
+	for (const auto& entry : m_cases)
+	{
+		std::printf("%s\n", entry.first.c_str());
+	}
+}
+
+double phx::bench::perSecond(double count, std::chrono::nanoseconds time)
+{
+	const double seconds = std::chrono::duration<double>(time).count();
+	return seconds > 0.0 ? count / seconds : 0.0;
+}
+
+void phx::bench::report(const std::string& what, double value,
+                        const std::string& unit)
+{
+	std::printf("  %-44s %14.1f %s\n", what.c_str(), value, unit.c_str());
+	std::fflush(stdout);
+}
+
+void phx::bench::keep(std::size_t value)
+{
+	// a volatile write can't be dropped, so neither can what it depends on.
+	g_sink = value;
+}
+
+std::size_t phx::bench::getBlock(const std::string& id, bool solid)
+{
+	voxels::BlockRegistry* registry = voxels::BlockRegistry::get();
+
+	// registering an ID twice keeps the first, so this is safe to repeat.
+	voxels::BlockType block;
+	block.displayName = id;
+	block.id          = id;
+	block.setAllTextures(id);
+	block.category =
+	    solid ? voxels::BlockCategory::SOLID : voxels::BlockCategory::AIR;
+	registry->registerBlock(block);
+
+	return registry->getFromID(id)->getRegistryID();
+}
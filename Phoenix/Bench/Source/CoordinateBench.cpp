@@ -0,0 +1,194 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Voxels/BlockRegistry.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// the loaded area, in chunks, around the origin - a bit bigger than a
+	// view distance of 4.
+	constexpr int AREA_RADIUS = 5;
+	constexpr int AREA_BOTTOM = -2;
+	constexpr int AREA_TOP    = 1;
+
+	constexpr std::size_t LOOKUPS = 1 << 18;
+
+	// random positions inside the loaded area, seeded so every run looks
+	// up the same blocks.
+	std::vector<voxels::BlockPos> makePositions()
+	{
+		std::mt19937 random(1234);
+
+		std::uniform_int_distribution<int> horizontal(
+		    -AREA_RADIUS * voxels::Chunk::CHUNK_WIDTH,
+		    AREA_RADIUS * voxels::Chunk::CHUNK_WIDTH - 1);
+		std::uniform_int_distribution<int> vertical(
+		    AREA_BOTTOM * voxels::Chunk::CHUNK_HEIGHT,
+		    (AREA_TOP + 1) * voxels::Chunk::CHUNK_HEIGHT - 1);
+
+		std::vector<voxels::BlockPos> positions(LOOKUPS);
+		for (voxels::BlockPos& pos : positions)
+		{
+			pos = {horizontal(random), vertical(random), horizontal(random)};
+		}
+
+		return positions;
+	}
+
+	void runSplitting()
+	{
+		const std::vector<voxels::BlockPos> positions = makePositions();
+
+		const auto shiftTime = measure([&positions] {
+			std::size_t sum = 0;
+			for (const voxels::BlockPos& pos : positions)
+			{
+				const voxels::ChunkPos chunk = voxels::toChunkPos(pos);
+				const voxels::BlockPos local = voxels::toLocalPos(pos);
+				sum += chunk.x + chunk.y + chunk.z + local.x + local.y +
+				       local.z;
+			}
+			keep(sum);
+		});
+
+		// how positions were split before they were integers, for
+		// comparison.
+		const auto floorTime = measure([&positions] {
+			std::size_t sum = 0;
+			for (const voxels::BlockPos& pos : positions)
+			{
+				const math::vec3 chunk = {
+				    std::floor(pos.x / static_cast<float>(
+				                           voxels::Chunk::CHUNK_WIDTH)),
+				    std::floor(pos.y / static_cast<float>(
+				                           voxels::Chunk::CHUNK_HEIGHT)),
+				    std::floor(pos.z / static_cast<float>(
+				                           voxels::Chunk::CHUNK_DEPTH))};
+				const math::vec3 local = {
+				    pos.x - chunk.x * voxels::Chunk::CHUNK_WIDTH,
+				    pos.y - chunk.y * voxels::Chunk::CHUNK_HEIGHT,
+				    pos.z - chunk.z * voxels::Chunk::CHUNK_DEPTH};
+				sum += static_cast<std::size_t>(chunk.x + chunk.y + chunk.z +
+				                                local.x + local.y + local.z);
+			}
+			keep(sum);
+		});
+
+		report("shift and mask", perSecond(LOOKUPS, shiftTime) / 1e6,
+		       "M/s");
+		report("float division and floor",
+		       perSecond(LOOKUPS, floorTime) / 1e6, "M/s");
+	}
+
+	void runLookups()
+	{
+		voxels::BlockType* stone = voxels::BlockRegistry::get()
+		                               ->getFromRegistryID(getBlock(
+		                                   "core.stone"));
+
+		// the same table and lookup that Map and ChunkView use, with the
+		// bottom half of the area filled in.
+		voxels::ChunkTable<std::unique_ptr<voxels::Chunk>> chunks;
+		for (int x = -AREA_RADIUS; x < AREA_RADIUS; ++x)
+		{
+			for (int y = AREA_BOTTOM; y <= AREA_TOP; ++y)
+			{
+				for (int z = -AREA_RADIUS; z < AREA_RADIUS; ++z)
+				{
+					const voxels::ChunkPos pos(x, y, z);
+
+					auto chunk = std::make_unique<voxels::Chunk>(pos);
+					for (int i = 0; y < 0 && i < 16 * 8 * 16; ++i)
+					{
+						chunk->setBlockAt(
+						    voxels::BlockPos(i % 16, i / 256, i / 16 % 16),
+						    stone);
+					}
+
+					chunks[pos] = std::move(chunk);
+				}
+			}
+		}
+
+		const auto lookup = [&chunks](const voxels::BlockPos& pos) {
+			const auto* chunk = chunks.find(voxels::toChunkPos(pos));
+			return chunk != nullptr
+			           ? (*chunk)->getBlockIDAt(voxels::toLocalPos(pos))
+			           : voxels::BlockRegistry::OUT_OF_BOUNDS_BLOCK;
+		};
+		const std::vector<voxels::BlockPos> positions = makePositions();
+
+		const auto randomTime = measure([&positions, &lookup] {
+			std::size_t sum = 0;
+			for (const voxels::BlockPos& pos : positions)
+			{
+				sum += lookup(pos);
+			}
+			keep(sum);
+		});
+
+		// walking along a line, like a raycast does - most lookups land in
+		// the same chunk as the last.
+		const int  width    = 2 * AREA_RADIUS * voxels::Chunk::CHUNK_WIDTH;
+		const auto lineTime = measure([&lookup, width] {
+			std::size_t sum = 0;
+			for (std::size_t i = 0; i < LOOKUPS; ++i)
+			{
+				const int x = static_cast<int>(i % width) -
+				              AREA_RADIUS * voxels::Chunk::CHUNK_WIDTH;
+				const int z = static_cast<int>(i / width % width) -
+				              AREA_RADIUS * voxels::Chunk::CHUNK_DEPTH;
+				sum += lookup(voxels::BlockPos(x, -4, z));
+			}
+			keep(sum);
+		});
+
+		report("random blocks", perSecond(LOOKUPS, randomTime) / 1e6, "M/s");
+		report("blocks along a line", perSecond(LOOKUPS, lineTime) / 1e6,
+		       "M/s");
+	}
+} // namespace
+
+void phx::bench::registerCoordinateCases(Suite& suite)
+{
+	suite.add("coordinates", runSplitting);
+	suite.add("block lookups", runLookups);
+}
@@ -0,0 +1,148 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Math/Noise.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <chrono>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// an area of 16x16 columns, from deep underground to above the
+	// highest hills.
+	constexpr int AREA_WIDTH  = 16;
+	constexpr int AREA_BOTTOM = -5;
+	constexpr int AREA_TOP    = 2;
+
+	// the frequency WorldGenerator samples its cave noise at.
+	constexpr float CAVE_FREQUENCY = 1.f / 32.f;
+
+	double toMicroseconds(std::chrono::nanoseconds time)
+	{
+		return std::chrono::duration<double, std::micro>(time).count();
+	}
+
+	void runGeneration()
+	{
+		getBlock("core.air", false);
+		getBlock("core.grass");
+		getBlock("core.dirt");
+		getBlock("core.stone");
+
+		voxels::WorldGeneratorStats stats;
+
+		// a new generator every run, so building the columns is measured
+		// too rather than coming from the last run's cache.
+		const auto time = measure([&stats] {
+			voxels::WorldGenerator generator(1234);
+			for (int x = 0; x < AREA_WIDTH; ++x)
+			{
+				for (int z = 0; z < AREA_WIDTH; ++z)
+				{
+					for (int y = AREA_BOTTOM; y <= AREA_TOP; ++y)
+					{
+						voxels::Chunk chunk(voxels::ChunkPos(x, y, z));
+						generator.generate(chunk);
+					}
+				}
+			}
+			stats = generator.getStats();
+		});
+
+		const double chunks = static_cast<double>(stats.chunks);
+
+		report("generating", perSecond(chunks, time), "chunks/s");
+		report("empty chunks", static_cast<double>(stats.emptyChunks),
+		       "chunks");
+		report("heightmap, per chunk", toMicroseconds(stats.heightmap) / chunks,
+		       "us");
+		report("surface, per chunk", toMicroseconds(stats.surface) / chunks,
+		       "us");
+		report("caves, per chunk", toMicroseconds(stats.caves) / chunks,
+		       "us");
+	}
+
+	void runNoise()
+	{
+		constexpr int SIZE   = 16;
+		constexpr int CHUNKS = 100;
+
+		const math::Noise noise(1234);
+
+		std::vector<float> samples(SIZE * SIZE * SIZE);
+
+		const auto pointTime = measure([&noise, &samples] {
+			for (int chunk = 0; chunk < CHUNKS; ++chunk)
+			{
+				float* out = samples.data();
+				for (int z = 0; z < SIZE; ++z)
+				{
+					for (int y = 0; y < SIZE; ++y)
+					{
+						for (int x = 0; x < SIZE; ++x)
+						{
+							*out++ = noise.at(
+							    static_cast<float>(chunk * SIZE + x) *
+							        CAVE_FREQUENCY,
+							    static_cast<float>(y) * CAVE_FREQUENCY,
+							    static_cast<float>(z) * CAVE_FREQUENCY);
+						}
+					}
+				}
+			}
+			keep(static_cast<std::size_t>(samples.back() * 1000.f));
+		});
+
+		const auto fillTime = measure([&noise, &samples] {
+			for (int chunk = 0; chunk < CHUNKS; ++chunk)
+			{
+				noise.fill3D(samples.data(),
+				             static_cast<float>(chunk * SIZE), 0.f, 0.f,
+				             SIZE, SIZE, SIZE, CAVE_FREQUENCY);
+			}
+			keep(static_cast<std::size_t>(samples.back() * 1000.f));
+		});
+
+		report("16^3 3D noise, one point at a time",
+		       toMicroseconds(pointTime) / CHUNKS, "us");
+		report("16^3 3D noise, fill3D", toMicroseconds(fillTime) / CHUNKS,
+		       "us");
+	}
+} // namespace
+
+void phx::bench::registerGenerationCases(Suite& suite)
+{
+	suite.add("generation", runGeneration);
+	suite.add("noise", runNoise);
+}
@@ -0,0 +1,123 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Logger.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace phx;
+
+namespace
+{
+	struct Options
+	{
+		std::string filter;
+		bool        list = false;
+	};
+
+	void printUsage()
+	{
+		std::cout << "Usage: PhoenixBench [options]\n"
+		             "Times the engine's hot paths, without a window.\n"
+		             "\n"
+		             "  --filter <text>  Only run cases with the text in "
+		             "their name.\n"
+		             "  --list           Print the cases instead of running "
+		             "them.\n";
+	}
+
+	// reads the options, returning false if they're not understood.
+	bool parseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string option = argv[i];
+
+			if (option == "--filter" && i + 1 < argc)
+			{
+				options.filter = argv[++i];
+			}
+			else if (option == "--list")
+			{
+				options.list = true;
+			}
+			else
+			{
+				std::cerr << "Unrecognised option: " << option << "\n";
+				return false;
+			}
+		}
+
+		return true;
+	}
+} // namespace
+
+#undef main
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	Logger::initialize({});
+
+	// new chunks are filled with air, which would otherwise resolve to the
+	// (solid) unknown block since no mods are loaded.
+	bench::getBlock("core.air", false);
+
+	bench::Suite suite;
+	bench::registerStorageCases(suite);
+	bench::registerCoordinateCases(suite);
+	bench::registerRegionCases(suite);
+	bench::registerRegistryCases(suite);
+	bench::registerMeshingCases(suite);
+	bench::registerViewCases(suite);
+	bench::registerGenerationCases(suite);
+
+	if (options.list)
+	{
+		suite.list();
+	}
+	else if (suite.run(options.filter) == 0)
+	{
+		std::cerr << "No cases match \"" << options.filter << "\".\n";
+
+		Logger::teardown();
+		return EXIT_FAILURE;
+	}
+
+	Logger::teardown();
+	return EXIT_SUCCESS;
+}
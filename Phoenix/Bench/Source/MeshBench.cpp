@@ -0,0 +1,299 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Client/Graphics/ChunkMesher.hpp>
+
+#include <Common/Voxels/BlockRegistry.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// the columns of chunks that are meshed, the generated area has a
+	// border of one more so every meshed chunk has all its neighbours.
+	constexpr int AREA_WIDTH  = 4;
+	constexpr int AREA_BOTTOM = -3;
+	constexpr int AREA_TOP    = 2;
+
+	// the offset of the chunk touching each face, in gfx::BlockFace order.
+	const std::array<voxels::ChunkPos, 6> NEIGHBOURS = {
+	    voxels::ChunkPos {0, 0, -1}, voxels::ChunkPos {-1, 0, 0},
+	    voxels::ChunkPos {0, 0, 1},  voxels::ChunkPos {1, 0, 0},
+	    voxels::ChunkPos {0, 1, 0},  voxels::ChunkPos {0, -1, 0},
+	};
+
+	// what the renderer would bake, minus the textures - every block gets
+	// its own layer so different blocks are never merged together.
+	gfx::ChunkRenderer::BlockLayerTable makeLayers()
+	{
+		const std::size_t blocks =
+		    voxels::BlockRegistry::get()->getProperties().size();
+
+		gfx::ChunkRenderer::BlockLayerTable layers(blocks);
+		for (std::size_t id = 0; id < blocks; ++id)
+		{
+			layers[id].fill(static_cast<std::uint16_t>(
+			    id % gfx::ChunkRenderer::MAX_TEXTURE_LAYERS));
+		}
+
+		return layers;
+	}
+
+	// the path-to-layer map the renderer used to hand the mesher, which
+	// resolved each face's texture by its path.
+	gfx::ChunkRenderer::AssociativeTextureTable makeTextures()
+	{
+		voxels::BlockRegistry* registry = voxels::BlockRegistry::get();
+
+		const std::size_t blocks = registry->getProperties().size();
+
+		gfx::ChunkRenderer::AssociativeTextureTable textures;
+		for (std::size_t id = 0; id < blocks; ++id)
+		{
+			for (const std::string& texture :
+			     registry->getFromRegistryID(id)->textures)
+			{
+				textures.emplace(texture,
+				                 textures.size() %
+				                     gfx::ChunkRenderer::MAX_TEXTURE_LAYERS);
+			}
+		}
+
+		return textures;
+	}
+
+	using Chunks = voxels::ChunkTable<std::unique_ptr<voxels::Chunk>>;
+
+	Chunks makeTerrain()
+	{
+		getBlock("core.air", false);
+		getBlock("core.grass");
+		getBlock("core.dirt");
+		getBlock("core.stone");
+
+		voxels::WorldGenerator generator(1234);
+
+		Chunks chunks;
+		for (int x = -1; x <= AREA_WIDTH; ++x)
+		{
+			for (int z = -1; z <= AREA_WIDTH; ++z)
+			{
+				for (int y = AREA_BOTTOM - 1; y <= AREA_TOP + 1; ++y)
+				{
+					const voxels::ChunkPos pos(x, y, z);
+
+					auto chunk = std::make_unique<voxels::Chunk>(pos);
+					generator.generate(*chunk);
+					chunks[pos] = std::move(chunk);
+				}
+			}
+		}
+
+		return chunks;
+	}
+
+	// meshes every chunk in the area, returning how many vertices that
+	// made.
+	std::size_t meshArea(const Chunks&                              chunks,
+	                     const gfx::ChunkRenderer::BlockLayerTable& layers,
+	                     gfx::MeshingMode                           mode)
+	{
+		std::size_t vertices = 0;
+		for (int x = 0; x < AREA_WIDTH; ++x)
+		{
+			for (int z = 0; z < AREA_WIDTH; ++z)
+			{
+				for (int y = AREA_BOTTOM; y <= AREA_TOP; ++y)
+				{
+					const voxels::ChunkPos pos(x, y, z);
+
+					gfx::ChunkMesher mesher(pos, **chunks.find(pos), layers);
+					for (std::size_t face = 0; face < NEIGHBOURS.size();
+					     ++face)
+					{
+						mesher.setNeighbour(
+						    static_cast<gfx::BlockFace>(face),
+						    chunks.find(pos + NEIGHBOURS[face])->get());
+					}
+
+					mesher.mesh(mode);
+
+					for (int section = 0; section < gfx::CHUNK_SECTION_COUNT;
+					     ++section)
+					{
+						vertices += mesher.getMesh(section).size();
+					}
+				}
+			}
+		}
+
+		return vertices;
+	}
+
+	void runMeshing()
+	{
+		const Chunks chunks = makeTerrain();
+		const auto   layers = makeLayers();
+
+		const double count =
+		    AREA_WIDTH * AREA_WIDTH * (AREA_TOP - AREA_BOTTOM + 1);
+
+		for (const gfx::MeshingMode mode :
+		     {gfx::MeshingMode::NAIVE, gfx::MeshingMode::GREEDY})
+		{
+			const char* name =
+			    mode == gfx::MeshingMode::NAIVE ? "naive" : "greedy";
+
+			std::size_t vertices = 0;
+
+			const auto time = measure([&] {
+				vertices = meshArea(chunks, layers, mode);
+			});
+
+			report(std::string(name) + ", vertices per chunk",
+			       vertices / count, "vertices");
+			report(std::string(name) + ", meshing",
+			       perSecond(count, time), "chunks/s");
+		}
+	}
+
+	void runFaces()
+	{
+		// registering can move the registry's blocks, so they're all
+		// registered before any pointers are taken.
+		std::vector<std::size_t> ids;
+		for (int i = 0; i < 16; ++i)
+		{
+			ids.push_back(getBlock("bench.mesh." + std::to_string(i)));
+		}
+
+		std::vector<voxels::BlockType*> blocks;
+		for (const std::size_t id : ids)
+		{
+			blocks.push_back(
+			    voxels::BlockRegistry::get()->getFromRegistryID(id));
+		}
+
+		// a 3D checkerboard of 16 different blocks and air, so every solid
+		// block shows all 6 faces and neighbouring faces never look the
+		// same - the most faces, and layer lookups, a chunk can have.
+		voxels::Chunk chunk(voxels::ChunkPos(0, 0, 0));
+
+		// each face the mesher emits, which it used to resolve through the
+		// path-to-layer map one at a time.
+		std::vector<std::pair<const voxels::BlockType*, std::size_t>> emitted;
+
+		for (int z = 0; z < voxels::Chunk::CHUNK_DEPTH; ++z)
+		{
+			for (int y = 0; y < voxels::Chunk::CHUNK_HEIGHT; ++y)
+			{
+				for (int x = 0; x < voxels::Chunk::CHUNK_WIDTH; ++x)
+				{
+					if ((x + y + z) % 2 == 0)
+					{
+						voxels::BlockType* block =
+						    blocks[(x / 2 + y * 3 + z * 5) % 16];
+						chunk.setBlockAt(voxels::BlockPos(x, y, z), block);
+
+						for (std::size_t face = 0; face < 6; ++face)
+						{
+							emitted.emplace_back(block, face);
+						}
+					}
+				}
+			}
+		}
+
+		const auto layers   = makeLayers();
+		const auto textures = makeTextures();
+
+		constexpr int CHUNKS = 20;
+
+		std::size_t vertices = 0;
+
+		const auto meshChunk = [&chunk, &layers, &vertices] {
+			gfx::ChunkMesher mesher(chunk.getChunkPos(), chunk, layers);
+			mesher.mesh(gfx::MeshingMode::NAIVE);
+
+			vertices = 0;
+			for (int section = 0; section < gfx::CHUNK_SECTION_COUNT;
+			     ++section)
+			{
+				vertices += mesher.getMesh(section).size();
+			}
+		};
+
+		const auto time = measure([&meshChunk] {
+			for (int i = 0; i < CHUNKS; ++i)
+			{
+				meshChunk();
+			}
+		});
+
+		// the same meshing, plus the per-face lookup it used to do.
+		const auto baselineTime = measure([&meshChunk, &emitted, &textures] {
+			for (int i = 0; i < CHUNKS; ++i)
+			{
+				meshChunk();
+
+				std::size_t sum = 0;
+				for (const auto& [block, face] : emitted)
+				{
+					sum += textures.at(block->textures[face]);
+				}
+				keep(sum);
+			}
+		});
+
+		const double faces =
+		    static_cast<double>(vertices / gfx::VERTICES_PER_QUAD) * CHUNKS;
+
+		report("faces per chunk", faces / CHUNKS, "faces");
+		report("naive meshing, texture lookup per face",
+		       perSecond(faces, baselineTime) / 1e6, "M faces/s");
+		report("naive meshing, block layer table",
+		       perSecond(faces, time) / 1e6, "M faces/s");
+	}
+} // namespace
+
+void phx::bench::registerMeshingCases(Suite& suite)
+{
+	suite.add("meshing", runMeshing);
+	suite.add("mesher faces", runFaces);
+}
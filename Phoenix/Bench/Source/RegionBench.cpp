@@ -0,0 +1,149 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkStore.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <filesystem>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// an area of 8x8 columns of chunks, from underground to the surface -
+	// 2x2 regions worth.
+	constexpr int AREA_WIDTH  = 8;
+	constexpr int AREA_BOTTOM = -5;
+	constexpr int AREA_TOP    = 2;
+
+	std::vector<voxels::Chunk> makeChunks()
+	{
+		getBlock("core.air", false);
+		getBlock("core.grass");
+		getBlock("core.dirt");
+		getBlock("core.stone");
+
+		voxels::WorldGenerator generator(1234);
+
+		std::vector<voxels::Chunk> chunks;
+		for (int x = 0; x < AREA_WIDTH; ++x)
+		{
+			for (int z = 0; z < AREA_WIDTH; ++z)
+			{
+				for (int y = AREA_BOTTOM; y <= AREA_TOP; ++y)
+				{
+					voxels::Chunk chunk(voxels::ChunkPos(x, y, z));
+					generator.generate(chunk);
+					chunks.push_back(std::move(chunk));
+				}
+			}
+		}
+
+		return chunks;
+	}
+
+	void runRegions()
+	{
+		namespace fs = std::filesystem;
+
+		std::vector<voxels::Chunk> chunks = makeChunks();
+
+		const fs::path directory =
+		    fs::temp_directory_path() / "PhoenixBench";
+
+		std::vector<data::Data> payloads(chunks.size());
+
+		const auto saveTime = measure([&chunks, &payloads] {
+			for (std::size_t i = 0; i < chunks.size(); ++i)
+			{
+				payloads[i] = chunks[i].save();
+			}
+		});
+
+		std::size_t bytes = 0;
+		for (const data::Data& payload : payloads)
+		{
+			bytes += payload.size();
+		}
+
+		// every run starts from an empty map, so it's measuring the writes
+		// rather than how the regions grow when chunks are saved again.
+		const auto writeTime = measure([&chunks, &payloads, &directory] {
+			std::error_code error;
+			fs::remove_all(directory, error);
+			fs::create_directories(directory, error);
+
+			voxels::ChunkStore store(directory.string(), "bench");
+			for (std::size_t i = 0; i < chunks.size(); ++i)
+			{
+				store.store(chunks[i].getChunkPos(), payloads[i]);
+			}
+			keep(store.flush());
+		});
+
+		// a new store every run, so the region files are opened again.
+		const auto readTime = measure([&chunks, &directory] {
+			voxels::ChunkStore store(directory.string(), "bench");
+
+			data::Data payload;
+			for (const voxels::Chunk& saved : chunks)
+			{
+				voxels::Chunk chunk(saved.getChunkPos());
+				if (store.load(saved.getChunkPos(), payload))
+				{
+					keep(chunk.load(payload));
+				}
+			}
+		});
+
+		std::error_code error;
+		fs::remove_all(directory, error);
+
+		const double count = static_cast<double>(chunks.size());
+		const double mib   = bytes / (1024.0 * 1024.0);
+
+		report("average payload", bytes / count, "bytes");
+		report("serializing", perSecond(count, saveTime), "chunks/s");
+		report("writing to regions", perSecond(count, writeTime),
+		       "chunks/s");
+		report("writing to regions", perSecond(mib, writeTime), "MiB/s");
+		report("reading and loading", perSecond(count, readTime),
+		       "chunks/s");
+		report("reading and loading", perSecond(mib, readTime), "MiB/s");
+	}
+} // namespace
+
+void phx::bench::registerRegionCases(Suite& suite)
+{
+	suite.add("regions", runRegions);
+}
@@ -0,0 +1,122 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Voxels/BlockRegistry.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// more than a heavily modded game registers.
+	constexpr std::size_t BLOCKS = 1500;
+
+	// the distinct blocks in a typical saved chunk.
+	constexpr std::size_t PALETTE_SIZE = 20;
+
+	constexpr std::size_t CHUNK_VOLUME = 4096;
+	constexpr std::size_t LOOKUPS      = 1 << 16;
+
+	void runRegistry()
+	{
+		std::vector<std::string> ids;
+		for (std::size_t i = 0; i < BLOCKS; ++i)
+		{
+			ids.push_back("bench.registry." + std::to_string(i));
+			getBlock(ids.back());
+		}
+
+		voxels::BlockRegistry* registry = voxels::BlockRegistry::get();
+
+		// seeded, so every run looks up the same blocks.
+		std::mt19937                               random(1234);
+		std::uniform_int_distribution<std::size_t> pick(0, BLOCKS - 1);
+
+		std::vector<std::string> lookups(LOOKUPS);
+		for (std::string& id : lookups)
+		{
+			id = ids[pick(random)];
+		}
+
+		std::vector<std::string> palette(PALETTE_SIZE);
+		for (std::string& id : palette)
+		{
+			id = ids[pick(random)];
+		}
+
+		// a chunk saved as one unique ID per block, like the old saves.
+		std::vector<std::string> voxels(CHUNK_VOLUME);
+		for (std::string& id : voxels)
+		{
+			id = palette[pick(random) % PALETTE_SIZE];
+		}
+
+		const auto lookupTime = measure([registry, &lookups] {
+			std::size_t sum = 0;
+			for (const std::string& id : lookups)
+			{
+				sum += registry->getFromID(id)->getRegistryID();
+			}
+			keep(sum);
+		});
+
+		const auto perVoxelTime = measure([registry, &voxels] {
+			std::size_t sum = 0;
+			for (const std::string& id : voxels)
+			{
+				sum += registry->getFromID(id)->getRegistryID();
+			}
+			keep(sum);
+		});
+
+		const auto paletteTime = measure([registry, &palette] {
+			for (int i = 0; i < 1000; ++i)
+			{
+				keep(registry->resolvePalette(palette).size());
+			}
+		});
+
+		report("getFromID", perSecond(LOOKUPS, lookupTime) / 1e6, "M/s");
+		report("chunk resolved block by block",
+		       perSecond(1, perVoxelTime), "chunks/s");
+		report("chunk resolved as a " + std::to_string(PALETTE_SIZE) +
+		           " block palette",
+		       perSecond(1000, paletteTime), "chunks/s");
+	}
+} // namespace
+
+void phx::bench::registerRegistryCases(Suite& suite)
+{
+	suite.add("registry", runRegistry);
+}
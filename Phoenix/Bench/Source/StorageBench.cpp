@@ -0,0 +1,170 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Common/Voxels/BlockStorage.hpp>
+#include <Common/Voxels/Chunk.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	constexpr std::size_t CHUNK_VOLUME = voxels::Chunk::CHUNK_WIDTH *
+	                                     voxels::Chunk::CHUNK_HEIGHT *
+	                                     voxels::Chunk::CHUNK_DEPTH;
+
+	// how many times each read and write pass goes over the chunk.
+	constexpr int PASSES = 64;
+
+	struct Pattern
+	{
+		std::string              name;
+		std::vector<std::size_t> blocks;
+	};
+
+	// the registry IDs of a chunk's blocks, from a handful of layouts
+	// ranging from a single block to a few hundred distinct ones.
+	std::vector<Pattern> makePatterns()
+	{
+		const std::size_t air   = getBlock("core.air", false);
+		const std::size_t grass = getBlock("core.grass");
+		const std::size_t dirt  = getBlock("core.dirt");
+		const std::size_t stone = getBlock("core.stone");
+
+		std::vector<std::size_t> many;
+		for (int i = 0; i < 256; ++i)
+		{
+			many.push_back(getBlock("bench.storage." + std::to_string(i)));
+		}
+
+		// seeded, so every run measures the same chunks.
+		std::mt19937 random(1234);
+
+		std::vector<Pattern> patterns;
+
+		patterns.push_back({"uniform", std::vector<std::size_t>(
+		                                   CHUNK_VOLUME, stone)});
+
+		Pattern layered {"layered", std::vector<std::size_t>(CHUNK_VOLUME)};
+		for (std::size_t i = 0; i < CHUNK_VOLUME; ++i)
+		{
+			const std::size_t y = (i / voxels::Chunk::CHUNK_WIDTH) %
+			                      voxels::Chunk::CHUNK_HEIGHT;
+
+			std::size_t block = air;
+			if (y < 10)
+				block = stone;
+			else if (y < 13)
+				block = dirt;
+			else if (y == 13)
+				block = grass;
+
+			layered.blocks[i] = block;
+		}
+		patterns.push_back(std::move(layered));
+
+		for (const std::size_t distinct : {16, 256})
+		{
+			std::uniform_int_distribution<std::size_t> pick(0, distinct - 1);
+
+			Pattern scattered {"scattered " + std::to_string(distinct),
+			                   std::vector<std::size_t>(CHUNK_VOLUME)};
+			for (std::size_t& block : scattered.blocks)
+			{
+				block = many[pick(random)];
+			}
+			patterns.push_back(std::move(scattered));
+		}
+
+		return patterns;
+	}
+
+	voxels::BlockStorage build(const std::vector<std::size_t>& blocks)
+	{
+		voxels::BlockStorage storage(blocks.size(), blocks.front());
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+		{
+			storage.set(i, blocks[i]);
+		}
+
+		return storage;
+	}
+
+	void runStorage()
+	{
+		report("4096 BlockType pointers, memory",
+		       static_cast<double>(CHUNK_VOLUME * sizeof(voxels::BlockType*)),
+		       "bytes");
+
+		for (const Pattern& pattern : makePatterns())
+		{
+			const voxels::BlockStorage storage = build(pattern.blocks);
+
+			report(pattern.name + ", memory",
+			       static_cast<double>(storage.getMemoryUsage()), "bytes");
+			report(pattern.name + ", index width",
+			       static_cast<double>(storage.getBitsPerIndex()), "bits");
+
+			const auto readTime = measure([&storage] {
+				std::size_t sum = 0;
+				for (int pass = 0; pass < PASSES; ++pass)
+				{
+					for (std::size_t i = 0; i < CHUNK_VOLUME; ++i)
+					{
+						sum += storage.get(i);
+					}
+				}
+				keep(sum);
+			});
+
+			const auto writeTime = measure([&pattern] {
+				for (int pass = 0; pass < PASSES; ++pass)
+				{
+					keep(build(pattern.blocks).size());
+				}
+			});
+
+			const double blocks = static_cast<double>(CHUNK_VOLUME) * PASSES;
+			report(pattern.name + ", reads",
+			       perSecond(blocks, readTime) / 1e6, "M/s");
+			report(pattern.name + ", writes",
+			       perSecond(blocks, writeTime) / 1e6, "M/s");
+		}
+	}
+} // namespace
+
+void phx::bench::registerStorageCases(Suite& suite)
+{
+	suite.add("storage", runStorage);
+}
@@ -0,0 +1,191 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Bench/Bench.hpp>
+
+#include <Client/Graphics/ActiveChunks.hpp>
+
+#include <Common/Voxels/Chunk.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phx::bench;
+using namespace phx;
+
+namespace
+{
+	// ChunkView's default unload margin.
+	constexpr int MARGIN = 2;
+
+	// how far the view walks each way, a tick per chunk.
+	constexpr int WALK = 16;
+
+	// the view distance the lookups are done at.
+	constexpr int LOOKUP_DISTANCE = 4;
+
+	constexpr std::size_t LOOKUPS = 1 << 18;
+
+	// what ChunkView::tick does with the active chunks after crossing into
+	// another chunk, as if every chunk it asked for loaded and was meshed
+	// straight away.
+	void tick(voxels::ActiveChunks& active, const voxels::ChunkPos& center)
+	{
+		// meshes are never pending, so nothing is let go of early.
+		keep(active
+		         .drop(center, MARGIN,
+		               [](const voxels::ChunkPos&) { return false; })
+		         .size());
+
+		active.rebuildLoadQueue(center, {1.f, 0.f, 0.f});
+
+		std::vector<voxels::ChunkPos>& queue = active.getLoadQueue();
+		while (!queue.empty())
+		{
+			active.add(queue.back(), nullptr);
+			queue.pop_back();
+		}
+	}
+
+	void runViewDistances()
+	{
+		for (const int viewDistance : {2, 4, 8, 12, 16})
+		{
+			voxels::ActiveChunks active(viewDistance);
+
+			voxels::ChunkPos center(0, 0, 0);
+			tick(active, center);
+
+			// there and back again, so every run starts from the same place.
+			const auto time = measure([&] {
+				for (int step = 0; step < 2 * WALK; ++step)
+				{
+					center.x += step < WALK ? 1 : -1;
+					tick(active, center);
+				}
+			});
+
+			const std::string name =
+			    "view distance " + std::to_string(viewDistance);
+
+			report(name + ", active chunks",
+			       static_cast<double>(active.size()), "chunks");
+			report(name + ", tick after moving",
+			       std::chrono::duration<double, std::micro>(time).count() /
+			           (2 * WALK),
+			       "us");
+		}
+	}
+
+	// the lookups behind ChunkView::getBlockAt() and the chunks
+	// ChunkView::setBlockAt() checks for remeshing, without the map or the
+	// mesher.
+	void runLookups()
+	{
+		voxels::ActiveChunks active(LOOKUP_DISTANCE);
+
+		std::vector<voxels::Chunk> chunks;
+		active.rebuildLoadQueue({0, 0, 0}, {1.f, 0.f, 0.f});
+		for (const voxels::ChunkPos& pos : active.getLoadQueue())
+		{
+			chunks.emplace_back(pos);
+		}
+
+		// the chunks are only pointed at once they're all made, so none of
+		// them move after.
+		for (voxels::Chunk& chunk : chunks)
+		{
+			active.add(chunk.getChunkPos(), &chunk);
+		}
+
+		active.getLoadQueue().clear();
+
+		// random blocks in view, seeded so every run looks up the same
+		// blocks.
+		std::mt19937 random(1234);
+
+		std::uniform_int_distribution<int> horizontal(
+		    -LOOKUP_DISTANCE * voxels::Chunk::CHUNK_WIDTH,
+		    (LOOKUP_DISTANCE + 1) * voxels::Chunk::CHUNK_WIDTH - 1);
+		std::uniform_int_distribution<int> vertical(
+		    -LOOKUP_DISTANCE * voxels::Chunk::CHUNK_HEIGHT,
+		    (LOOKUP_DISTANCE + 1) * voxels::Chunk::CHUNK_HEIGHT - 1);
+
+		std::vector<voxels::BlockPos> positions(LOOKUPS);
+		for (voxels::BlockPos& pos : positions)
+		{
+			pos = {horizontal(random), vertical(random), horizontal(random)};
+		}
+
+		const auto getTime = measure([&active, &positions] {
+			std::size_t sum = 0;
+			for (const voxels::BlockPos& pos : positions)
+			{
+				sum += active.getBlockIDAt(pos);
+			}
+			keep(sum);
+		});
+
+		// setBlockAt() only remeshes the chunks that are active.
+		const auto countRemeshed = [&active](const voxels::BlockPos& pos) {
+			std::size_t count = 0;
+			voxels::ActiveChunks::forEachEdited(
+			    pos, [&active, &count](const voxels::ChunkPos& chunk,
+			                           gfx::SectionMask) {
+				    count += active.contains(chunk) ? 1 : 0;
+			    });
+			return count;
+		};
+
+		std::size_t remeshed = 0;
+		const auto  setTime  = measure([&positions, &countRemeshed, &remeshed] {
+			remeshed = 0;
+			for (const voxels::BlockPos& pos : positions)
+			{
+				remeshed += countRemeshed(pos);
+			}
+		});
+
+		report("view lookups, active chunks",
+		       static_cast<double>(active.size()), "chunks");
+		report("view lookups, getBlockAt", perSecond(LOOKUPS, getTime) / 1e6,
+		       "M/s");
+		report("view lookups, setBlockAt remesh checks",
+		       perSecond(LOOKUPS, setTime) / 1e6, "M/s");
+		report("view lookups, chunks remeshed per edit",
+		       static_cast<double>(remeshed) / LOOKUPS, "chunks");
+	}
+} // namespace
+
+void phx::bench::registerViewCases(Suite& suite)
+{
+	suite.add("view distance", runViewDistances);
+	suite.add("view lookups", runLookups);
+}
@@ -51,6 +51,10 @@ namespace phx::client
 		void popLayer(gfx::Layer* layer);
 		bool isDebugLayerActive() const { return m_debugOverlayActive; }
 
+		// the chunk statistics shown by the debug overlay, or nullptr if
+		// there's no world to show them for.
+		void setChunkStats(const voxels::ChunkViewStats* stats);
+
 		audio::Audio*      getAudioHandler() { return m_audio; }
 		audio::SourcePool* getAudioPool() { return &m_audioPool; }
 
@@ -68,6 +72,8 @@ namespace phx::client
 		
 		bool          m_debugOverlayActive = false;
 		DebugOverlay* m_debugOverlay       = nullptr;
+
+		const voxels::ChunkViewStats* m_chunkStats = nullptr;
 	};
 } // namespace phx::client
 
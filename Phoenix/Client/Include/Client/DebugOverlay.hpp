@@ -31,6 +31,12 @@
 #include <Client/Events/Event.hpp>
 #include <Client/Graphics/Layer.hpp>
 
+namespace phx::voxels
+{
+	// forward declaration
+	struct ChunkViewStats;
+} // namespace phx::voxels
+
 namespace phx::client
 {
 	/**
@@ -50,6 +56,13 @@ namespace phx::client
 		void onEvent(events::Event& e) override;
 		void tick(float dt) override;
 
+		/**
+		 * @brief Sets the chunk statistics to show.
+		 * @param stats The statistics of the world's ChunkView, or nullptr
+		 * to hide them.
+		 */
+		void setChunkStats(const voxels::ChunkViewStats* stats);
+
 	private:
 		bool m_wireframe     = false;
 		int  m_sampleRate    = 60;
@@ -57,6 +70,8 @@ namespace phx::client
 		bool m_pauseSampling = false;
 
 		unsigned int m_time = 0;
+
+		const voxels::ChunkViewStats* m_chunkStats = nullptr;
 	};
 } // namespace phx::client
 
@@ -80,6 +80,11 @@ namespace phx::client
 		 */
 		void sendMessage(const std::string& input, std::ostringstream& cout);
 
+	private:
+		// registers the voxel.world and voxel.region functions, which work
+		// on m_world once it exists.
+		void registerWorldAPI(cms::ModManager* manager);
+
 	private:
 		gfx::Window*       m_window;
 		gfx::FPSCamera*    m_camera = nullptr;
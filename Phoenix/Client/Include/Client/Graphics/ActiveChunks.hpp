@@ -0,0 +1,196 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ActiveChunks.hpp
+ * @brief The chunks a ChunkView is drawing, and the ones it still wants.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Client/Graphics/ChunkRenderer.hpp>
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Keeps track of the chunks in view.
+	 *
+	 * This is the bookkeeping half of a ChunkView - which chunks are
+	 * active, which ones it should let go of as the player moves, which
+	 * ones to load next and which ones an edit has to remesh. It doesn't
+	 * touch the map, the mesher or OpenGL, the ChunkView decides what
+	 * happens to the chunks this hands back.
+	 *
+	 * Lookups, membership tests and neighbour lookups are all constant
+	 * time, the chunks are kept in a ChunkTable.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ActiveChunks active(viewDistance);
+	 *
+	 * for (const ChunkPos& pos : active.drop(center, margin, cancel))
+	 * {
+	 *     renderer->dropChunk(pos);
+	 * }
+	 *
+	 * active.rebuildLoadQueue(center, direction);
+	 * @endcode
+	 */
+	class ActiveChunks
+	{
+	public:
+		/// @brief Picks the chunks to let go of early, see drop().
+		using CancelCallback = std::function<bool(const ChunkPos&)>;
+
+		/// @brief Remeshes sections of a chunk, see forEachEdited().
+		using RemeshCallback =
+		    std::function<void(const ChunkPos&, gfx::SectionMask)>;
+
+		/**
+		 * @brief The offset of the chunk touching each face, in
+		 * gfx::BlockFace order.
+		 */
+		static const std::array<ChunkPos, 6> NEIGHBOURS;
+
+		/**
+		 * @brief Constructs an empty set of active chunks.
+		 * @param viewDistance The view distance in every direction.
+		 */
+		explicit ActiveChunks(int viewDistance);
+
+		/// @brief Gets the view distance in every direction, in chunks.
+		int getViewDistance() const { return m_viewDistance; }
+
+		/**
+		 * @brief Finds an active chunk in constant time.
+		 * @param pos The position of the chunk.
+		 * @return The chunk, or nullptr if it isn't active.
+		 */
+		Chunk* find(const ChunkPos& pos) const;
+
+		/// @brief Checks if a chunk is active.
+		bool contains(const ChunkPos& pos) const;
+
+		/**
+		 * @brief Makes a chunk active.
+		 * @param pos The position of the chunk.
+		 * @param chunk The chunk, owned by the map.
+		 */
+		void add(const ChunkPos& pos, Chunk* chunk);
+
+		/// @brief Gets the amount of active chunks.
+		std::size_t size() const { return m_chunks.size(); }
+
+		/**
+		 * @brief Gets the registry ID of an active chunk's block.
+		 * @param position The position of the block.
+		 * @return The registry ID of the block, or
+		 * BlockRegistry::OUT_OF_BOUNDS_BLOCK if its chunk isn't active.
+		 */
+		std::size_t getBlockIDAt(const BlockPos& position) const;
+
+		/**
+		 * @brief Lets go of the chunks that aren't needed anymore.
+		 * @param center The chunk the player is in.
+		 * @param margin How far past the view distance meshed chunks are
+		 * kept, in chunks.
+		 * @param cancel Called for chunks that just left view, cancels the
+		 * chunk's mesh and returns whether it was still waiting for one.
+		 * @return The chunks that were let go of.
+		 *
+		 * Chunks that left view before their mesh was ready aren't worth
+		 * meshing anymore, so they're let go of straight away. Meshed
+		 * chunks are kept until they're past the margin, so walking back
+		 * and forth over a chunk border doesn't drop and remesh the same
+		 * chunks.
+		 */
+		std::vector<ChunkPos> drop(const ChunkPos& center, int margin,
+		                           const CancelCallback& cancel);
+
+		/**
+		 * @brief Refills the load queue with the chunks in view that
+		 * aren't active yet.
+		 * @param center The chunk the player is in.
+		 * @param direction The normalized direction the camera is looking
+		 * in, or zero.
+		 *
+		 * Chunks are queued nearest first, favouring the ones in front of
+		 * the camera. The most important are at the back of the queue.
+		 */
+		void rebuildLoadQueue(const ChunkPos&   center,
+		                      const math::vec3& direction);
+
+		/// @brief Gets the chunks waiting to be loaded, in queue order.
+		std::vector<ChunkPos>& getLoadQueue() { return m_loadQueue; }
+
+		/// @brief Gets the direction the load queue was last built for.
+		const math::vec3& getQueueDirection() const
+		{
+			return m_queueDirection;
+		}
+
+		/**
+		 * @brief Finds the chunks whose mesh an edit to a block changes.
+		 * @param position The position of the edited block.
+		 * @param remesh Called with each chunk and the sections of it to
+		 * remesh, whether the chunk is active or not.
+		 *
+		 * Only the section holding the block needs remeshing, plus the
+		 * sections touching the block in the chunk or chunks next to it.
+		 */
+		static void forEachEdited(const BlockPos&      position,
+		                          const RemeshCallback& remesh);
+
+		/// @brief Checks if a chunk is within a distance of another.
+		static bool isWithin(const ChunkPos& pos, const ChunkPos& center,
+		                     int distance);
+
+	private:
+		int m_viewDistance;
+
+		// the map owns the chunks, these are the ones being drawn.
+		ChunkTable<Chunk*> m_chunks;
+
+		// every offset within the view distance, nearest first.
+		std::vector<ChunkPos> m_viewOffsets;
+
+		// chunks waiting to be loaded and meshed, popped from the back.
+		std::vector<ChunkPos> m_loadQueue;
+		math::vec3            m_queueDirection;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,136 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ArenaAllocator.hpp
+ * @brief Hands out ranges of a fixed size buffer.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <map>
+
+namespace phx::gfx
+{
+	/**
+	 * @brief Hands out ranges of a fixed size buffer, keeping track of the
+	 * gaps left behind by freed ranges.
+	 *
+	 * This only does the book keeping, it doesn't own any memory - it's
+	 * used to split one large GPU buffer between every chunk section, so
+	 * sizes and offsets are in whatever unit the owner likes.
+	 *
+	 * Allocation is first fit, and freed ranges are merged with the gaps
+	 * either side of them, so the free space stays in as few pieces as
+	 * possible. When it does end up too scattered to fit a range, the owner
+	 * is expected to move everything to the front of the buffer and call
+	 * reset().
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ArenaAllocator arena(1024);
+	 *
+	 * const std::size_t offset = arena.allocate(16);
+	 * if (offset != ArenaAllocator::INVALID)
+	 * {
+	 *     // use [offset, offset + 16) of the buffer.
+	 *     arena.free(offset, 16);
+	 * }
+	 * @endcode
+	 */
+	class ArenaAllocator
+	{
+	public:
+		/// @brief Returned when there's no gap large enough.
+		static constexpr std::size_t INVALID =
+		    std::numeric_limits<std::size_t>::max();
+
+		/**
+		 * @brief Constructs an empty arena.
+		 * @param capacity The size of the buffer being split up.
+		 */
+		explicit ArenaAllocator(std::size_t capacity);
+
+		/**
+		 * @brief Reserves a range of the buffer.
+		 * @param size The size of the range, must not be 0.
+		 * @return The offset of the range, or INVALID if there's no gap
+		 * large enough.
+		 */
+		std::size_t allocate(std::size_t size);
+
+		/**
+		 * @brief Returns a range to the arena.
+		 * @param offset The offset allocate() returned for it.
+		 * @param size The size it was allocated with.
+		 */
+		void free(std::size_t offset, std::size_t size);
+
+		/**
+		 * @brief Starts over with a new buffer that's only used at the
+		 * front.
+		 * @param capacity The size of the new buffer.
+		 * @param used How much of the front is already in use.
+		 *
+		 * This is for after everything's been packed into a new buffer,
+		 * either to get rid of the gaps or to make room.
+		 */
+		void reset(std::size_t capacity, std::size_t used);
+
+		/// @brief Gets the size of the buffer being split up.
+		std::size_t getCapacity() const { return m_capacity; }
+
+		/// @brief Gets how much of the buffer is allocated.
+		std::size_t getUsed() const { return m_used; }
+
+		/// @brief Gets how many separate gaps the free space is split into.
+		std::size_t getFreeBlockCount() const { return m_free.size(); }
+
+		/// @brief Gets the largest range that could be allocated right now.
+		std::size_t getLargestFreeBlock() const;
+
+		/**
+		 * @brief Gets how scattered the free space is.
+		 * @return 0 if the free space is all in one piece, approaching 1
+		 * the more of it is in small gaps that the largest one can't
+		 * account for.
+		 */
+		float getFragmentation() const;
+
+	private:
+		std::size_t m_capacity;
+		std::size_t m_used = 0;
+
+		// the offset and size of every gap, in order.
+		std::map<std::size_t, std::size_t> m_free;
+	};
+} // namespace phx::gfx
@@ -0,0 +1,207 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkMeshPool.hpp
+ * @brief Meshes chunks on a pool of worker threads.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Client/Graphics/ChunkMesher.hpp>
+#include <Client/Graphics/ChunkRenderer.hpp>
+
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phx::gfx
+{
+	/**
+	 * @brief A finished mesh, ready to be uploaded.
+	 */
+	struct ChunkMeshResult
+	{
+		/// @brief The position of the chunk the mesh is for.
+		voxels::ChunkPos pos;
+		/// @brief The sections that were meshed, the rest are empty.
+		SectionMask sections;
+		/// @brief The mesh of each section.
+		std::array<std::vector<ChunkVertex>, CHUNK_SECTION_COUNT> meshes;
+	};
+
+	/**
+	 * @brief Meshes chunks on a pool of worker threads.
+	 *
+	 * submit() takes snapshots of the chunk and its neighbours, so the
+	 * originals can keep being edited while they're meshed. Snapshots share
+	 * their blocks with the map's chunks (see voxels::ChunkSnapshot), so
+	 * nothing is copied unless a chunk is edited while one of its jobs is
+	 * in flight. Finished meshes are
+	 * collected on the main thread with pop(), which is where they should
+	 * be uploaded since OpenGL can't be used from the workers.
+	 *
+	 * Only the newest job for a chunk counts - submitting a chunk again
+	 * (after an edit, for example) cancels any job for it that's still
+	 * queued, being meshed or waiting to be popped. The new job takes over
+	 * the sections the cancelled one was going to mesh, so nothing is
+	 * lost. cancel() drops the job without queuing a new one, for chunks
+	 * that are no longer needed.
+	 *
+	 * The block registry and layer table are read from the workers, so
+	 * they must not change while the pool exists.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkMeshPool pool(3, renderer->getBlockLayers());
+	 * pool.submit(map.getSnapshot(pos), neighbours, MeshingMode::GREEDY);
+	 *
+	 * // every frame.
+	 * ChunkMeshResult result;
+	 * while (pool.pop(result))
+	 * {
+	 *     for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+	 *     {
+	 *         if (result.sections & (1u << section))
+	 *         {
+	 *             renderer->updateChunk(result.meshes[section], result.pos,
+	 *                                   section);
+	 *         }
+	 *     }
+	 * }
+	 * @endcode
+	 */
+	class ChunkMeshPool
+	{
+	public:
+		/// @brief The chunk touching each face, in BlockFace order.
+		using Neighbours = std::array<voxels::ChunkSnapshot, 6>;
+
+		/**
+		 * @brief Starts the worker threads.
+		 * @param threads How many workers to start, at least one is.
+		 * @param layers The block layer table baked by the renderer.
+		 */
+		ChunkMeshPool(std::size_t                           threads,
+		              const ChunkRenderer::BlockLayerTable& layers);
+
+		/// @brief Drops any jobs left and stops the workers.
+		~ChunkMeshPool();
+
+		ChunkMeshPool(const ChunkMeshPool&) = delete;
+		ChunkMeshPool& operator=(const ChunkMeshPool&) = delete;
+
+		/**
+		 * @brief Queues a chunk to be meshed.
+		 * @param chunk A snapshot of the chunk to mesh.
+		 * @param neighbours The chunk touching each face, nullptr if it
+		 * isn't loaded.
+		 * @param mode How to mesh the chunk.
+		 * @param sections The sections of the chunk to mesh.
+		 * @param urgent Whether to mesh this before everything already
+		 * queued, so edits don't wait behind newly loaded terrain.
+		 */
+		void submit(voxels::ChunkSnapshot chunk, const Neighbours& neighbours,
+		            MeshingMode mode, SectionMask sections = ALL_SECTIONS,
+		            bool urgent = false);
+
+		/**
+		 * @brief Cancels any job for a chunk.
+		 * @param pos The position of the chunk.
+		 * @return Whether the chunk was still waiting for a mesh.
+		 */
+		bool cancel(const voxels::ChunkPos& pos);
+
+		/**
+		 * @brief Takes a finished mesh, in the order they finished.
+		 * @param result Where to store the mesh.
+		 * @return Whether there was a finished mesh.
+		 */
+		bool pop(ChunkMeshResult& result);
+
+		/// @brief Gets how many chunks are still waiting for a mesh.
+		std::size_t getPendingCount();
+
+	private:
+		struct Job
+		{
+			std::uint64_t         generation;
+			MeshingMode           mode;
+			SectionMask           sections;
+			voxels::ChunkSnapshot chunk;
+			Neighbours            neighbours;
+		};
+
+		// the newest job for a chunk, and every section it has to mesh.
+		struct Pending
+		{
+			std::uint64_t generation = 0;
+			SectionMask   sections   = 0;
+		};
+
+		struct Finished
+		{
+			std::uint64_t   generation;
+			ChunkMeshResult result;
+		};
+
+		void run();
+
+		// whether a job is the newest one for its chunk, m_mutex must be
+		// held.
+		bool isLatest(const voxels::ChunkPos& pos,
+		              std::uint64_t           generation) const;
+
+	private:
+		const ChunkRenderer::BlockLayerTable& m_layers;
+
+		// guards everything below.
+		std::mutex                       m_mutex;
+		std::condition_variable          m_wake;
+		std::deque<std::unique_ptr<Job>> m_jobs;
+		std::deque<Finished>             m_finished;
+
+		// the newest job for every chunk still waiting for a mesh,
+		// anything older is stale.
+		voxels::ChunkTable<Pending> m_latest;
+		std::uint64_t               m_nextGeneration = 1;
+		bool                        m_stop           = false;
+
+		std::vector<std::thread> m_threads;
+	};
+} // namespace phx::gfx
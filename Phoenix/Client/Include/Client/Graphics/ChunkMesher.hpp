@@ -39,7 +39,9 @@
 
 #include <Common/Math/Math.hpp>
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/Chunk.hpp>
 
+#include <array>
 #include <vector>
 
 namespace phx::gfx
@@ -61,23 +63,40 @@ namespace phx::gfx
 		BOTTOM
 	};
 
+	/**
+	 * @brief The ways a chunk can be meshed.
+	 */
+	enum class MeshingMode
+	{
+		/// @brief Every visible face of every block gets its own quad.
+		NAIVE,
+
+		/// @brief Neighbouring faces that look the same are merged into a
+		/// single, larger quad.
+		GREEDY
+	};
+
 	/**
 	 * @brief Meshes a chunk.
 	 *
-	 * Once provided with a reference to the blocks within a chunk and a
-	 * ready built texture table gotten from the ChunkRenderer, it can mesh
-	 * the chunks very simply.
+	 * Once provided with a reference to the chunk being meshed and the
+	 * block layer table baked by the ChunkRenderer, it can mesh the chunks
+	 * very simply.
+	 *
+	 * By default faces are meshed greedily (see MeshingMode). Faces hidden
+	 * by blocks in neighbouring chunks are culled too, as long as the
+	 * neighbours are provided with setNeighbour().
 	 *
-	 * This mesher does not understand "smart" meshing, it will mesh only
-	 * this chunk, and will not take neighbor chunks into account as of yet.
-	 * As the project gains maturity and we have more features, this will be
-	 * improved.
+	 * The mesh is split into CHUNK_SECTION_COUNT sections, each
+	 * CHUNK_SECTION_HEIGHT blocks tall. Faces are never merged across
+	 * sections, so a single section can be remeshed after an edit without
+	 * touching the rest of the chunk.
 	 *
 	 * @paragraph Usage
 	 * @code
-	 * ChunkMesher mesher(chunkPosition, chunk.getBlocks(),
-	 * renderer->getTextureTable()) mesher.mesh()
-	 * renderer->submitChunk(mesher.getMesh(), chunkPosition);
+	 * ChunkMesher mesher(chunkPosition, chunk,
+	 * renderer->getBlockLayers()) mesher.mesh()
+	 * renderer->submitChunk(mesher.getMesh(0), chunkPosition, 0);
 	 * @endcode
 	 *
 	 */
@@ -86,38 +105,99 @@ namespace phx::gfx
 	public:
 		/**
 		 * @brief Constructs the mesher based on a few parameters.
-		 * @param pos The position of the chunk.
-		 * @param blocks A reference to the array of blocks in the chunk.
-		 * @param texTable The texture table values created by the renderer.
+		 * @param pos The position of the chunk, in chunks.
+		 * @param chunk A reference to the chunk being meshed.
+		 * @param layers The block layer table baked by the renderer.
 		 */
-		ChunkMesher(math::vec3 pos, std::vector<voxels::BlockType*>& blocks,
-		            const ChunkRenderer::AssociativeTextureTable& texTable)
-		    : m_pos(pos), m_blockRef(blocks), m_texTable(texTable)
+		ChunkMesher(voxels::ChunkPos pos, const voxels::Chunk& chunk,
+		            const ChunkRenderer::BlockLayerTable& layers)
+		    : m_pos(pos), m_chunk(chunk), m_layers(layers)
 		{
 		}
 		~ChunkMesher() = default;
 
+		/**
+		 * @brief Provides the chunk neighbouring a face of this chunk.
+		 * @param face The face of this chunk the neighbour is touching.
+		 * @param neighbour The neighbouring chunk, nullptr if not loaded.
+		 *
+		 * Neighbours are used to cull the faces on the edge of the chunk
+		 * that are hidden by the neighbour, and to skip chunks that can't
+		 * possibly be seen. Without a neighbour every face on that edge is
+		 * kept, so it's best to wait for all six to be loaded.
+		 */
+		void setNeighbour(BlockFace face, const voxels::Chunk* neighbour);
+
 		/**
 		 * @brief Meshes the chunk.
+		 * @param mode How to turn the visible faces into quads.
+		 * @param sections The sections to mesh, the rest are left empty.
+		 *
+		 * Chunks that are entirely air, and uniformly solid chunks that are
+		 * enclosed by uniformly solid neighbours on every side, produce an
+		 * empty mesh without visiting a single block.
+		 *
+		 * Greedy meshing produces far fewer vertices for flat terrain (a
+		 * flat 16x16 surface is one quad rather than 256), at the cost of
+		 * a little more work while meshing.
 		 */
-		void mesh();
+		void mesh(MeshingMode mode     = MeshingMode::GREEDY,
+		          SectionMask sections = ALL_SECTIONS);
 
 		/**
-		 * @brief Returns the mesh as an array of floats.
-		 * @return The mesh as an array of floats.
+		 * @brief Returns the mesh of a section as an array of packed
+		 * vertices.
+		 * @param section The section to get the mesh of.
+		 * @return The mesh, with positions relative to the chunk. Every
+		 * quad is 4 vertices, to be drawn through ChunkRenderer's shared
+		 * index buffer.
 		 */
-		const std::vector<float>& getMesh() const { return m_mesh; }
+		const std::vector<ChunkVertex>& getMesh(int section) const
+		{
+			return m_meshes[section];
+		}
 
 	private:
-		// internal function, no need to document.
-		void addBlockFace(voxels::BlockType* block, BlockFace face, float x,
-		                  float y, float z);
+		// everything needed to mesh a block, resolved once per palette
+		// entry rather than once per block.
+		struct PaletteEntry
+		{
+			bool                       opaque;
+			std::uint16_t              color;
+			std::array<std::size_t, 6> layers;
+		};
+
+		// the opacity of the blocks in and around the sections being
+		// meshed, with a one block border from the neighbours so faces on
+		// the edge can be culled too.
+		std::vector<std::uint8_t> buildOpacity(
+		    const std::vector<PaletteEntry>& palette,
+		    SectionMask                      sections) const;
+
+		void meshNaive(const std::vector<PaletteEntry>& palette,
+		               const std::vector<std::uint8_t>& opaque,
+		               SectionMask                      sections);
+		void meshGreedy(const std::vector<PaletteEntry>& palette,
+		                const std::vector<std::uint8_t>& opaque,
+		                SectionMask                      sections);
+
+		// adds a quad to a section covering width x height blocks, starting
+		// at pos and running along the face's UV axes.
+		void addQuad(int section, const PaletteEntry& block, BlockFace face,
+		             const voxels::BlockPos& pos, int width, int height);
+
+		// whether there is no need to look at any individual block.
+		bool canSkip() const;
 
 	private:
-		math::vec3                                    m_pos;
-		std::vector<float>                            m_mesh;
-		std::vector<voxels::BlockType*>               m_blockRef;
-		const ChunkRenderer::AssociativeTextureTable& m_texTable;
+		using SectionMeshes =
+		    std::array<std::vector<ChunkVertex>, CHUNK_SECTION_COUNT>;
+
+		voxels::ChunkPos                      m_pos;
+		SectionMeshes                         m_meshes;
+		const voxels::Chunk&                  m_chunk;
+		const ChunkRenderer::BlockLayerTable& m_layers;
+		std::array<const voxels::Chunk*, 6>   m_neighbours {};
 	};
 } // namespace phx::gfx
 
@@ -35,8 +35,16 @@
 
 #pragma once
 
+#include <Client/Graphics/ArenaAllocator.hpp>
 #include <Client/Graphics/ShaderPipeline.hpp>
 
+#include <Common/Math/Frustum.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <array>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
@@ -45,6 +53,53 @@ namespace phx::gfx
 	// forward declaration
 	class ShaderPipeline;
 
+	/**
+	 * @brief A single vertex of a chunk mesh, packed into 8 bytes.
+	 *
+	 * Positions are the corner of a block relative to the chunk, so each
+	 * axis only ever holds 0 to 16 - the chunk's position is given to the
+	 * shader once per draw instead. The normal and UVs are worked out in
+	 * the shader from the face and the position.
+	 */
+	struct ChunkVertex
+	{
+		/// @brief From the lowest bit up: x, y and z (5 bits each), the
+		/// BlockFace (3 bits) and the texture layer (8 bits).
+		std::uint32_t data;
+		/// @brief The block's color, as rrrrggggbbbbaaaa.
+		std::uint32_t color;
+	};
+
+	static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex should be packed.");
+
+	/// @brief How tall each separately meshed section of a chunk is.
+	constexpr int CHUNK_SECTION_HEIGHT = 4;
+
+	/// @brief How many sections a chunk is split into, from the bottom up.
+	constexpr int CHUNK_SECTION_COUNT =
+	    voxels::Chunk::CHUNK_HEIGHT / CHUNK_SECTION_HEIGHT;
+
+	/// @brief A set of sections, where bit n is section n.
+	using SectionMask = std::uint32_t;
+
+	/// @brief Every section of a chunk.
+	constexpr SectionMask ALL_SECTIONS = (1u << CHUNK_SECTION_COUNT) - 1;
+
+	/// @brief How many vertices each face of a mesh is made of.
+	constexpr int VERTICES_PER_QUAD = 4;
+
+	/// @brief How many indices it takes to draw a face as two triangles.
+	constexpr int INDICES_PER_QUAD = 6;
+
+	/// @brief The most faces a section can ever have, every side of every
+	/// block.
+	constexpr int MAX_QUADS_PER_SECTION = voxels::Chunk::CHUNK_WIDTH *
+	                                      voxels::Chunk::CHUNK_DEPTH *
+	                                      CHUNK_SECTION_HEIGHT * 6;
+
+	static_assert(MAX_QUADS_PER_SECTION * VERTICES_PER_QUAD <= 0xFFFF,
+	              "Sections are drawn with 16 bit indices.");
+
 	/**
 	 * @brief A struct to store the data required to render chunks.
 	 *
@@ -53,12 +108,42 @@ namespace phx::gfx
 	 */
 	struct ChunkRenderData
 	{
-		/// @brief The vertex array object.
-		unsigned int vao;
-		/// @brief The buffer object.
-		unsigned int buffer;
-		/// @brief The amount of vertices to render.
-		std::size_t vertexCount;
+		/// @brief The first vertex of the section in the chunk arena.
+		std::size_t first = 0;
+		/// @brief The amount of vertices reserved for the section in the
+		/// arena, 0 if nothing's been uploaded.
+		std::size_t capacity = 0;
+		/// @brief The amount of vertices to render, 4 for every quad.
+		std::size_t vertexCount = 0;
+	};
+
+	/**
+	 * @brief How many sections were sent to the GPU by the last render,
+	 * and how many were skipped for being off screen.
+	 */
+	struct ChunkRenderStats
+	{
+		/// @brief The sections that were drawn.
+		std::size_t drawn = 0;
+		/// @brief The sections outside the view frustum.
+		std::size_t culled = 0;
+
+		/// @brief The size of the chunk arena, in bytes.
+		std::size_t arenaCapacity = 0;
+		/// @brief The bytes of the arena reserved by sections.
+		std::size_t arenaReserved = 0;
+		/// @brief The bytes of the arena holding vertices, the rest of what
+		/// is reserved is slack for sections to grow into.
+		std::size_t arenaUsed = 0;
+		/// @brief How many gaps the free space of the arena is split into.
+		std::size_t arenaFreeBlocks = 0;
+		/// @brief How scattered the free space is, see
+		/// ArenaAllocator::getFragmentation().
+		float arenaFragmentation = 0.f;
+		/// @brief How many times the arena has been compacted or grown.
+		std::size_t compactions = 0;
+		/// @brief The bytes moved by the last compaction.
+		std::size_t compactedBytes = 0;
 	};
 
 	/**
@@ -83,14 +168,17 @@ namespace phx::gfx
 	 *
 	 * Chunk chunk = Chunk({0, 0, 0});
 	 *
-	 * ChunkMesher mesher({0, 0, 0}, chunk, renderer->getTextureTable());
+	 * ChunkMesher mesher({0, 0, 0}, chunk, renderer->getBlockLayers());
 	 * mesher.mesh();
 	 *
-	 * renderer->submitChunk(mesher.getMesh(), { 0, 0, 0 });
-	 * //renderer->updateChunk(mesher.getMesh(), { 0, 0, 0 });
+	 * for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+	 * {
+	 *     renderer->updateChunk(mesher.getMesh(section), { 0, 0, 0 },
+	 *                           section);
+	 * }
 	 * //renderer->dropChunk({ 0, 0, 0 });
 	 *
-	 * renderer->render():
+	 * renderer->render(projection * view);
 	 * @endcode
 	 *
 	 * @todo Find solution to the max texture limit. Not urgent but hopefully by
@@ -103,6 +191,14 @@ namespace phx::gfx
 		using AssociativeTextureTable =
 		    std::unordered_map<std::string, std::size_t>;
 
+		/// @brief The texture array layer of each face of every block, by
+		/// registry ID.
+		using BlockLayerTable = std::vector<std::array<std::uint16_t, 6>>;
+
+		/// @brief The most layers the texture array holds, which is also all
+		/// that fits in a ChunkVertex's 8 bit texture layer.
+		static constexpr std::size_t MAX_TEXTURE_LAYERS = 256;
+
 		/**
 		 * @brief Constructs a chunk renderer which will accept a specific
 		 * amount of chunks.
@@ -129,8 +225,9 @@ namespace phx::gfx
 		 * the TextureRegistry, which comes from the BlockRegistry in this
 		 * context.
 		 *
-		 * This does have the caveat of being unable to be larger than 256
-		 * layers, aka 256 textures - a texture array is essentially a 3D
+		 * This does have the caveat of being unable to be larger than
+		 * MAX_TEXTURE_LAYERS layers, aka 256 textures - any past that are
+		 * left out and put on layer 0 - a texture array is essentially a 3D
 		 * array where the Z-axis can just be layer that we are storing the
 		 * texture on. This ia a OpenGL thing so internal understanding is
 		 * not necessary unless modifying/improving this function.
@@ -146,61 +243,154 @@ namespace phx::gfx
 		const AssociativeTextureTable& getTextureTable() const;
 
 		/**
-		 * @brief Uploads and prepares a chunk's Mesh for rendering.
+		 * @brief Gets the texture array layer of each face of every block.
+		 * @return A table indexed by registry ID, then by BlockFace.
+		 *
+		 * This is baked by buildTextureArray(), so every block must be
+		 * registered before then. Faces without a texture, or whose texture
+		 * failed to load, are on layer 0.
+		 */
+		const BlockLayerTable& getBlockLayers() const;
+
+		/**
+		 * @brief Uploads and prepares a section of a chunk's Mesh for
+		 * rendering.
 		 * @param mesh The meshed data to upload and render.
 		 * @param pos The position of the chunk that the mesh of for.
+		 * @param section The section of the chunk the mesh is for.
+		 *
+		 * Every section of a chunk has its own range of the chunk arena, so
+		 * editing a block only means uploading the sections around it.
 		 *
-		 * This function does not check if a mesh for requested chunk exists
-		 * beforehand so keep track manually and make sure you're not
-		 * attempting to submit the same chunk multiple times. This is not
+		 * This function does not check if a mesh for requested section
+		 * exists beforehand so keep track manually and make sure you're not
+		 * attempting to submit the same section multiple times. This is not
 		 * the fastest function, so if the chunk already exists, don't just
 		 * drop and submit again, try to update since that will be more
 		 * efficient in the long run.
 		 *
-		 * If the chunk has no vertices (all air), it will not create an
-		 * entry in the internal list, since there is no point, however, a
+		 * Meshes are lists of quads, 4 vertices each, and are drawn through
+		 * an index buffer shared by every section - see QUAD_INDICES.
+		 *
+		 * If the section has no vertices (all air), it will not reserve any
+		 * space, since there is no point, however, a
 		 * redundancy has been built into updateChunk just in case, to make
 		 * sure you don't have to check whether the chunk is air manually
 		 * and knowing whether it is submitted or not.
 		 */
-		void submitChunk(const std::vector<float>& mesh, math::vec3 pos);
+		void submitChunk(const std::vector<ChunkVertex>& mesh,
+		                 voxels::ChunkPos pos, int section);
 
 		/**
-		 * @brief Updates the new mesh for a previously submitted chunk.
-		 * @param mesh The mesh of the updated chunk.
+		 * @brief Updates the new mesh for a previously submitted section.
+		 * @param mesh The mesh of the updated section.
 		 * @param pos The position of the chunk you're updating.
+		 * @param section The section of the chunk you're updating.
 		 *
 		 * This function has a redundancy that will automatically run
-		 * "submitChunk" if the chunk doesn't exist in the internal list.
+		 * "submitChunk" if the section doesn't exist in the internal list.
 		 * This is more efficient for updating chunks since it won't
-		 * reallocate the GPU-side buffer if the mesh size is the same.
+		 * reallocate the section's range of the arena if the mesh still
+		 * fits in it.
 		 */
-		void updateChunk(const std::vector<float>& mesh, math::vec3 pos);
+		void updateChunk(const std::vector<ChunkVertex>& mesh,
+		                 voxels::ChunkPos pos, int section);
 
 		/**
 		 * @brief Deletes the stated chunk from the GPU.
 		 * @param pos The position of the chunk to drop.
+		 *
+		 * The chunk's ranges go back to the arena, to be reused by the next
+		 * chunks that are uploaded.
+		 */
+		void dropChunk(voxels::ChunkPos pos);
+
+		/**
+		 * @brief Renders the active chunks that are in view.
+		 * @param viewProjection The projection matrix multiplied by the
+		 * view matrix, the same as the shader uses.
+		 *
+		 * The shader prepared with getRequiredShaderLayout() must be active,
+		 * since each chunk's position is read through its u_chunkOrigins
+		 * texture, which is bound to texture unit 1.
+		 *
+		 * Every section is tested against the view frustum as a box first,
+		 * so only the ones that could be on screen are drawn. Everything
+		 * that's left is drawn with a single glMultiDrawElementsBaseVertex
+		 * call.
 		 */
-		void dropChunk(math::vec3 pos);
+		void render(const math::mat4& viewProjection);
 
 		/**
-		 * @brief Renders the active chunks.
+		 * @brief Gets how many sections the last render drew and culled,
+		 * and how the chunk arena is holding up.
+		 * @return The statistics of the last render.
 		 */
-		void render();
+		const ChunkRenderStats& getStats() const;
+
+		/// @brief The order each quad's 4 corners are drawn in, as two
+		/// triangles.
+		static constexpr std::array<std::uint16_t, INDICES_PER_QUAD>
+		    QUAD_INDICES = {0, 1, 2, 2, 3, 0};
 
 	private:
-		std::unordered_map<math::vec3, ChunkRenderData, math::Vector3Hasher,
-		                   math::Vector3KeyComparator>
-		             m_buffers;
-		unsigned int m_textureArray = 0;
+		using SectionRenderData =
+		    std::array<ChunkRenderData, CHUNK_SECTION_COUNT>;
+
+		// uploads a mesh into the arena, in place if it fits in what the
+		// section already has reserved.
+		void upload(const std::vector<ChunkVertex>& mesh,
+		            voxels::ChunkPos pos, ChunkRenderData& data);
+
+		// gives a section's range back to the arena.
+		void release(ChunkRenderData& data);
+
+		// reserves a range of granules, compacting or growing the arena if
+		// there's no gap large enough.
+		std::size_t allocate(std::size_t granules);
+
+		// moves every section to the front of a new arena buffer.
+		void compact(std::size_t granules);
+
+		// points the vertex array and origin texture at the arena buffers.
+		void bindArena();
 
-		const int m_vertexAttributeLocation = 0;
-		const int m_uvAttributeLocation     = 1;
-		const int m_normalAttributeLocation = 2;
-		const int m_colorAttributeLocation  = 3;
-		// const int m_posAttributeLocation    = 4;
+		voxels::ChunkTable<SectionRenderData> m_buffers;
+		unsigned int                          m_textureArray = 0;
+		unsigned int                          m_quadIndices  = 0;
+
+		// every section's vertices live in one buffer, drawn through one
+		// vertex array. The buffer is split into granules of a fixed
+		// number of vertices, and the origin of the chunk each granule
+		// belongs to is kept in a texture buffer the shader reads.
+		unsigned int   m_vao           = 0;
+		unsigned int   m_arenaBuffer   = 0;
+		unsigned int   m_originBuffer  = 0;
+		unsigned int   m_originTexture = 0;
+		ArenaAllocator m_arena;
+
+		// a copy of the origin buffer, as x, y, z, 0 for every granule.
+		std::vector<std::int32_t> m_origins;
+
+		// the vertices actually in use across every section.
+		std::size_t m_vertexCount = 0;
+
+		const int m_dataAttributeLocation  = 0;
+		const int m_colorAttributeLocation = 1;
 
 		AssociativeTextureTable m_textureTable;
+		BlockLayerTable         m_blockLayers;
+
+		// the sections with something to draw, their bounds, and the
+		// arguments for drawing the visible ones, reused every frame.
+		std::vector<const ChunkRenderData*> m_drawList;
+		math::AABBList                      m_drawBounds;
+		std::vector<std::uint8_t>           m_drawVisible;
+		std::vector<int>                    m_drawCounts;
+		std::vector<int>                    m_drawBaseVertices;
+		std::vector<const void*>            m_drawOffsets;
+
+		ChunkRenderStats m_stats;
 	};
 } // namespace phx::gfx
 
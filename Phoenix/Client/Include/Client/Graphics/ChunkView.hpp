@@ -28,14 +28,39 @@
 
 #pragma once
 
+#include <Client/Graphics/ActiveChunks.hpp>
+#include <Client/Graphics/ChunkMeshPool.hpp>
+#include <Client/Graphics/ChunkMesher.hpp>
 #include <Client/Graphics/ChunkRenderer.hpp>
 
 #include <Common/Voxels/Map.hpp>
 
-#include <vector>
+#include <optional>
 
 namespace phx::voxels
 {
+	/**
+	 * @brief What a ChunkView is holding on to, for keeping an eye on
+	 * memory over long sessions.
+	 */
+	struct ChunkViewStats
+	{
+		/// @brief The statistics of the last render.
+		gfx::ChunkRenderStats render;
+		/// @brief The chunks resident in the map.
+		std::size_t loadedChunks = 0;
+		/// @brief Roughly how many bytes the resident chunks' blocks take.
+		std::size_t loadedBytes = 0;
+		/// @brief The chunks that are meshed, or waiting to be.
+		std::size_t activeChunks = 0;
+		/// @brief The chunks in view still waiting to be loaded and meshed.
+		std::size_t queuedChunks = 0;
+		/// @brief The chunks the map is still loading or generating.
+		std::size_t generatingChunks = 0;
+		/// @brief The chunks unloaded since the view was created.
+		std::size_t unloadedChunks = 0;
+	};
+
 	/**
 	 * @brief Generation and Rendering manager for the "world".
 	 *
@@ -60,9 +85,10 @@ namespace phx::voxels
 	 * {
 	 *     camera.tick(dt);
 	 *
-	 *     world.tick(camera.getPosition());
+	 *     world.tick(camera.getPosition(), camera.getDirection());
 	 *
-	 *     world.render();
+	 *     world.render(camera.getProjection() *
+	 *                  camera.calculateViewMatrix());
 	 * }
 	 * @endcode
 	 */
@@ -81,6 +107,7 @@ namespace phx::voxels
 		 * @brief Updates visible chunk depending on player position.
 		 * @param playerPos The position of the player, should be straight
 		 * from the camera - conversion calculations done internally.
+		 * @param viewDirection The direction the camera is looking in.
 		 *
 		 * This method will load/unload chunks as required while moving
 		 * around as the player. When the player position is sent, it should
@@ -88,15 +115,45 @@ namespace phx::voxels
 		 * camera coordinates to voxel coordinates is done internally. This
 		 * needs to be repaired and done explicitly through external code.
 		 *
+		 * Chunks are loaded nearest first, favouring the ones in front of
+		 * the camera. The map loads them in the background - only the first
+		 * "graphics:chunkLoadBudget" chunks in the queue are requested at
+		 * a time, and "graphics:meshSubmitBudget" of the ones that have
+		 * loaded (along with their neighbours) are submitted for meshing
+		 * per call.
+		 * The queue is only rebuilt when the player crosses into another
+		 * chunk or turns far enough to change what's in front of them.
+		 *
+		 * Chunks are meshed in the background, this only uploads the
+		 * meshes that have finished - up to the "graphics:meshUploadBudget"
+		 * setting (in KiB) per call, so walking into new terrain doesn't
+		 * stall the frame.
+		 *
+		 * Chunks are only let go of once they're "graphics:unloadMargin"
+		 * chunks further away than they need to be, so walking back and
+		 * forth over a chunk border doesn't unload and reload the same
+		 * chunks. Their meshes are dropped first, giving their space in the
+		 * renderer's arena back, then the chunks themselves are unloaded
+		 * from the map - saving them first if they were edited.
+		 *
 		 * @todo Create classes to solve said issue, decide on whether to
 		 * rely on explicit or implicit conversion of coordinate systems.
 		 */
-		void tick(math::vec3 playerPos);
+		void tick(math::vec3 playerPos, const math::vec3& viewDirection);
 
 		/**
-		 * @brief Renders active chunks.
+		 * @brief Renders the active chunks that are in view.
+		 * @param viewProjection The camera's projection matrix multiplied
+		 * by its view matrix.
 		 */
-		void render();
+		void render(const math::mat4& viewProjection);
+
+		/**
+		 * @brief Gets how much the view is holding on to, and how the last
+		 * render went.
+		 * @return The view's statistics.
+		 */
+		const ChunkViewStats& getStats() const;
 
 		/**
 		 * @brief Gets the block at a specific position.
@@ -104,21 +161,88 @@ namespace phx::voxels
 		 * @return The block in said position.
 		 * @return "core.out_of_bounds" if an invalid position is provided.
 		 */
-		BlockType* getBlockAt(math::vec3 position) const;
+		BlockType* getBlockAt(const BlockPos& position) const;
+
+		/**
+		 * @brief Gets the registry ID of the block at a specific position.
+		 * @param position The position of the block to get.
+		 * @return The registry ID of the block in said position.
+		 * @return BlockRegistry::OUT_OF_BOUNDS_BLOCK if an invalid position
+		 * is provided.
+		 */
+		std::size_t getBlockIDAt(const BlockPos& position) const;
 
 		/**
 		 * @brief Sets the block at a specific position.
 		 * @param position The position to set a block.
 		 * @param block The block to set.
 		 */
-		void setBlockAt(math::vec3 position, BlockType* block);
+		void setBlockAt(const BlockPos& position, BlockType* block);
+
+		/**
+		 * @brief Sets every block in a box to the same block.
+		 * @param min One corner of the box.
+		 * @param max The opposite corner, also inside the box.
+		 * @param block The block to fill the box with.
+		 * @return Whether the box was filled.
+		 *
+		 * See Map::fill(), every chunk the box touches is remeshed once.
+		 */
+		bool fill(const BlockPos& min, const BlockPos& max, BlockType* block);
+
+		/**
+		 * @brief Copies the blocks in a box.
+		 * @param min One corner of the box.
+		 * @param max The opposite corner, also inside the box.
+		 * @return The registry IDs of every block in the box, or nothing if
+		 * the box can't be read (see Map::isUsableBox()).
+		 */
+		std::optional<BlockRegion> read(const BlockPos& min,
+		                                const BlockPos& max);
+
+		/**
+		 * @brief Copies a region of blocks into the world.
+		 * @param region The blocks to copy, such as from read().
+		 * @param origin Where the region's lowest corner goes.
+		 * @return Whether the region was written.
+		 */
+		bool write(const BlockRegion& region, const BlockPos& origin);
 
 	private:
-		int m_viewDistance = 1; // 1 chunk
+		// remeshes sections of a chunk if it's active.
+		void remesh(const ChunkPos& chunkPos, gfx::SectionMask sections);
+
+		// remeshes every section whose mesh could be changed by edits to a
+		// box of blocks, including the neighbours touching its sides.
+		void remeshRegion(const BlockPos& min, const BlockPos& max);
+
+		// loads and submits chunks off the load queue until the budgets
+		// run out.
+		void processLoadQueue();
+
+		// snapshots the loaded chunks surrounding the provided one.
+		gfx::ChunkMeshPool::Neighbours getNeighbours(
+		    const ChunkPos& chunkPos) const;
 
-		std::vector<Chunk>  m_activeChunks;
+		// the meshing mode picked in the "graphics:greedyMeshing" setting.
+		gfx::MeshingMode getMeshingMode() const;
+
+	private:
+		ActiveChunks        m_activeChunks;
 		gfx::ChunkRenderer* m_renderer;
+		gfx::ChunkMeshPool* m_meshPool;
 		Map                 m_map;
+		Setting*            m_greedyMeshing;
+		Setting*            m_uploadBudget;
+		Setting*            m_unloadMargin;
+		Setting*            m_loadBudget;
+		Setting*            m_meshBudget;
+
+		// where the player was the last time chunks were unloaded.
+		ChunkPos m_lastCenter;
+		bool     m_hasLastCenter = false;
+
+		ChunkViewStats m_stats;
 	};
 } // namespace phx::voxels
 
@@ -65,6 +65,14 @@ void Client::popLayer(gfx::Layer* layer)
 	}
 }
 
+void Client::setChunkStats(const voxels::ChunkViewStats* stats)
+{
+	m_chunkStats = stats;
+
+	if (m_debugOverlay != nullptr)
+		m_debugOverlay->setChunkStats(stats);
+}
+
 void Client::onEvent(events::Event e)
 {
 	using namespace events;
@@ -82,7 +90,10 @@ void Client::onEvent(events::Event e)
 			if (m_debugOverlayActive)
 			{
 				if (m_debugOverlay == nullptr)
+				{
 					m_debugOverlay = new DebugOverlay();
+					m_debugOverlay->setChunkStats(m_chunkStats);
+				}
 
 				m_layerStack.pushLayer(m_debugOverlay);
 			}
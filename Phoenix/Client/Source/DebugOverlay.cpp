@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <Client/DebugOverlay.hpp>
+#include <Client/Graphics/ChunkView.hpp>
 
 #include <Client/Graphics/ImGuiExtensions.hpp>
 #include <imgui.h>
@@ -56,6 +57,11 @@ void DebugOverlay::onDetach() {}
 
 void DebugOverlay::onEvent(events::Event& e) {}
 
+void DebugOverlay::setChunkStats(const voxels::ChunkViewStats* stats)
+{
+	m_chunkStats = stats;
+}
+
 void DebugOverlay::tick(float dt)
 {
 	ImGui::Begin("Phoenix");
@@ -73,6 +79,35 @@ void DebugOverlay::tick(float dt)
 		ImGui::Text("Frame Time: %.2f ms/frame\n", dt * 1000.f);
 		ImGui::Text("FPS: %d\n", static_cast<int>(1.f / dt));
 
+		if (m_chunkStats != nullptr)
+		{
+			const gfx::ChunkRenderStats& render = m_chunkStats->render;
+
+			ImGui::Text("Chunk Sections Drawn: %zu\n", render.drawn);
+			ImGui::Text("Chunk Sections Culled: %zu\n", render.culled);
+
+			const float mebibyte = 1024.f * 1024.f;
+			ImGui::Text("Chunk Arena: %.1f used, %.1f reserved, %.1f MiB\n",
+			            render.arenaUsed / mebibyte,
+			            render.arenaReserved / mebibyte,
+			            render.arenaCapacity / mebibyte);
+			ImGui::Text("Arena Fragmentation: %.0f%% (%zu gaps)\n",
+			            render.arenaFragmentation * 100.f,
+			            render.arenaFreeBlocks);
+			ImGui::Text("Arena Compactions: %zu (last moved %.1f MiB)\n",
+			            render.compactions, render.compactedBytes / mebibyte);
+
+			ImGui::Text("Chunks Loaded: %zu (%.1f MiB)\n",
+			            m_chunkStats->loadedChunks,
+			            m_chunkStats->loadedBytes / mebibyte);
+			ImGui::Text("Chunks Active: %zu\n", m_chunkStats->activeChunks);
+			ImGui::Text("Chunks Queued: %zu\n", m_chunkStats->queuedChunks);
+			ImGui::Text("Chunks Generating: %zu\n",
+			            m_chunkStats->generatingChunks);
+			ImGui::Text("Chunks Unloaded: %zu\n",
+			            m_chunkStats->unloadedChunks);
+		}
+
 		ImGui::SliderInt("Debug Sample Rate", &m_sampleRate, 1, 60);
 		ImGui::Checkbox("Pause Debug Graph", &m_pauseSampling);
 
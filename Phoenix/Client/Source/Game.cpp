@@ -39,6 +39,7 @@
 #include <Common/Logger.hpp>
 
 #include <cmath>
+#include <memory>
 #include <tuple>
 
 using namespace phx::client;
@@ -53,6 +54,49 @@ using namespace phx;
 */
 static Game* myGame = nullptr;
 
+static voxels::BlockPos tableToBlockPos(const sol::table& table)
+{
+	return {table.get_or("x", 0), table.get_or("y", 0), table.get_or("z", 0)};
+}
+
+// checks the world API can be used yet, telling the mod if it can't.
+static bool isWorldLoaded(const voxels::ChunkView* world,
+                          const char*              function)
+{
+	if (world == nullptr)
+	{
+		LOG_WARNING("MODULE") << function
+		                      << " can't be used before the world is loaded.";
+		return false;
+	}
+
+	return true;
+}
+
+// tells the mod why the world refused a box, see Map::isUsableBox().
+static void warnUnusableBox(const char* function)
+{
+	LOG_WARNING("MODULE") << function
+	                      << " was given a box outside of the world, or "
+	                         "bigger than "
+	                      << voxels::Map::MAX_REGION_VOLUME << " blocks.";
+}
+
+// finds a registered block, telling the mod if it isn't.
+static voxels::BlockType* findBlock(const std::string& id,
+                                    const char*        function)
+{
+	voxels::BlockType* block = voxels::BlockRegistry::get()->getFromID(id);
+	if (block->getRegistryID() == voxels::BlockRegistry::UNKNOWN_BLOCK)
+	{
+		LOG_WARNING("MODULE") << function << " was given \"" << id
+		                      << "\", which isn't a registered block.";
+		return nullptr;
+	}
+
+	return block;
+}
+
 static void rawEcho(const std::string& input, std::ostringstream& cout)
 {
 	myGame->sendMessage(input, cout);
@@ -263,6 +307,7 @@ void Game::onAttach()
 
 	m_player = new Player(m_registry);
 	m_player->registerAPI(m_modManager);
+	registerWorldAPI(m_modManager);
 
 	float progress = 0.f;
 	auto  result   = m_modManager->load(&progress);
@@ -276,6 +321,7 @@ void Game::onAttach()
 	LOG_INFO("MAIN") << "Registering world";
 	const std::string save = "save1";
 	m_world = new voxels::ChunkView(3, voxels::Map(save, "map1"));
+	Client::get()->setChunkStats(&m_world->getStats());
 	m_player->setWorld(m_world);
 	m_camera = new gfx::FPSCamera(m_window, m_registry);
 	m_camera->setActor(m_player->getEntity());
@@ -315,6 +361,7 @@ void Game::onAttach()
 void Game::onDetach()
 {
 	m_network->stop();
+	Client::get()->setChunkStats(nullptr);
 	delete m_world;
 	delete m_player;
 	delete m_camera;
@@ -435,7 +482,7 @@ void Game::tick(float dt)
 	m_listener->setPosition(position.position);
 	m_listener->setVelocity({ 0, 0, 0 });
 
-	m_world->tick(m_prevPos);
+	m_world->tick(m_prevPos, m_camera->getDirection());
 
 	m_chat->draw();
 
@@ -446,7 +493,8 @@ void Game::tick(float dt)
 	m_renderPipeline.setVector3("u_LightDir", lightdir);
 	m_renderPipeline.setFloat("u_Brightness", 0.6f);
 
-	m_world->render();
+	m_world->render(m_camera->getProjection() *
+	                m_camera->calculateViewMatrix());
 	m_player->renderSelectionBox(m_camera->calculateViewMatrix(),
 	                             m_camera->getProjection());
 }
@@ -455,3 +503,181 @@ void Game::sendMessage(const std::string& input, std::ostringstream& cout)
 {
 	m_network->sendMessage(input);
 }
+
+void Game::registerWorldAPI(cms::ModManager* manager)
+{
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelworldfill voxel.world.fill
+	 * @brief Sets every block in a box to the same block.
+	 *
+	 * This works a chunk at a time in C++, so it's far cheaper than
+	 * setting the blocks one at a time. Boxes are limited to 128^3 blocks.
+	 *
+	 * @param min One corner of the box, a table with x, y and z.
+	 * @param max The opposite corner, also inside the box.
+	 * @param id The ID of the block to fill with, such as "core.stone".
+	 * @return Whether the box was filled.
+	 *
+	 * @b Example:
+	 * @code {.lua}
+	 * voxel.world.fill({x = 0, y = 0, z = 0}, {x = 9, y = 3, z = 9},
+	 *                  "core.dirt")
+	 * @endcode
+	 */
+	manager->registerFunction(
+	    "voxel.world.fill",
+	    [this](sol::table min, sol::table max, const std::string& id) {
+		    if (!isWorldLoaded(m_world, "voxel.world.fill"))
+			    return false;
+
+		    voxels::BlockType* block = findBlock(id, "voxel.world.fill");
+		    if (block == nullptr)
+			    return false;
+
+		    if (!m_world->fill(tableToBlockPos(min), tableToBlockPos(max),
+		                       block))
+		    {
+			    warnUnusableBox("voxel.world.fill");
+			    return false;
+		    }
+
+		    return true;
+	    });
+
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelworldread voxel.world.read
+	 * @brief Copies the blocks in a box into a region.
+	 *
+	 * The region is userdata holding the blocks packed together, it can be
+	 * written back with voxel.world.write and looked at with the
+	 * voxel.region functions. Boxes are limited to 128^3 blocks.
+	 *
+	 * @param min One corner of the box, a table with x, y and z.
+	 * @param max The opposite corner, also inside the box.
+	 * @return The region, or nil if the box couldn't be read.
+	 */
+	manager->registerFunction(
+	    "voxel.world.read",
+	    [this](sol::table min,
+	           sol::table max) -> std::shared_ptr<voxels::BlockRegion> {
+		    if (!isWorldLoaded(m_world, "voxel.world.read"))
+			    return nullptr;
+
+		    std::optional<voxels::BlockRegion> region =
+		        m_world->read(tableToBlockPos(min), tableToBlockPos(max));
+		    if (!region)
+		    {
+			    warnUnusableBox("voxel.world.read");
+			    return nullptr;
+		    }
+
+		    // regions can be megabytes, so Lua gets the one that was read
+		    // rather than a copy.
+		    return std::make_shared<voxels::BlockRegion>(std::move(*region));
+	    });
+
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelworldwrite voxel.world.write
+	 * @brief Copies a region into the world.
+	 *
+	 * @param region A region from voxel.world.read.
+	 * @param origin Optional, where the region's lowest corner goes. The
+	 * region is written back where it was read from if this is left out.
+	 * @return Whether the region was written.
+	 *
+	 * @b Example:
+	 * @code {.lua}
+	 * -- copies a small house 20 blocks along.
+	 * local house = voxel.world.read({x = 0, y = 0, z = 0},
+	 *                                {x = 7, y = 5, z = 7})
+	 * voxel.world.write(house, {x = 20, y = 0, z = 0})
+	 * @endcode
+	 */
+	manager->registerFunction(
+	    "voxel.world.write", [this](const voxels::BlockRegion& region,
+	                                sol::optional<sol::table> origin) {
+		    if (!isWorldLoaded(m_world, "voxel.world.write"))
+			    return false;
+
+		    const voxels::BlockPos low =
+		        origin ? tableToBlockPos(*origin) : region.getMin();
+		    if (!m_world->write(region, low))
+		    {
+			    warnUnusableBox("voxel.world.write");
+			    return false;
+		    }
+
+		    return true;
+	    });
+
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelregionget voxel.region.get
+	 * @brief Gets a block in a region.
+	 *
+	 * @param region A region from voxel.world.read.
+	 * @param pos The position of the block, relative to the region's
+	 * lowest corner.
+	 * @return The ID of the block, or nil if it's outside the region.
+	 */
+	manager->registerFunction(
+	    "voxel.region.get",
+	    [](const voxels::BlockRegion& region, sol::table pos) {
+		    const voxels::BlockPos local = tableToBlockPos(pos);
+		    if (!region.isInBounds(local))
+			    return sol::optional<std::string> {};
+
+		    return sol::optional<std::string> {
+		        voxels::BlockRegistry::get()
+		            ->getFromRegistryID(region.getBlockIDAt(local))
+		            ->id};
+	    });
+
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelregionset voxel.region.set
+	 * @brief Sets a block in a region, without touching the world.
+	 *
+	 * @param region A region from voxel.world.read.
+	 * @param pos The position of the block, relative to the region's
+	 * lowest corner.
+	 * @param id The ID of the block, such as "core.stone".
+	 * @return Whether the block was set.
+	 */
+	manager->registerFunction(
+	    "voxel.region.set", [](voxels::BlockRegion& region, sol::table pos,
+	                           const std::string& id) {
+		    const voxels::BlockPos local = tableToBlockPos(pos);
+		    voxels::BlockType*     block = findBlock(id, "voxel.region.set");
+		    if (!region.isInBounds(local) || block == nullptr)
+			    return false;
+
+		    region.setBlockIDAt(local, block->getRegistryID());
+		    return true;
+	    });
+
+	/**
+	 * @addtogroup luaapi
+	 *
+	 * @subsubsection voxelregionsize voxel.region.getSize
+	 * @brief Gets how many blocks a region spans on each axis.
+	 *
+	 * @param region A region from voxel.world.read.
+	 * @return The width, height and depth of the region.
+	 */
+	manager->registerFunction("voxel.region.getSize",
+	                          [](const voxels::BlockRegion& region) {
+		                          const voxels::BlockPos& size =
+		                              region.getSize();
+		                          return std::make_tuple(size.x, size.y,
+		                                                 size.z);
+	                          });
+}
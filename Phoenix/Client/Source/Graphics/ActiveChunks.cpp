@@ -0,0 +1,223 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Client/Graphics/ActiveChunks.hpp>
+#include <Client/Graphics/ChunkMesher.hpp>
+
+#include <Common/Voxels/BlockRegistry.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace phx::voxels;
+using namespace phx;
+
+// the squared length of an offset, in chunks.
+static int lengthSquared(const ChunkPos& offset)
+{
+	return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+}
+
+const std::array<ChunkPos, 6> ActiveChunks::NEIGHBOURS = {
+    ChunkPos {0, 0, -1}, ChunkPos {-1, 0, 0}, ChunkPos {0, 0, 1},
+    ChunkPos {1, 0, 0},  ChunkPos {0, 1, 0},  ChunkPos {0, -1, 0},
+};
+
+ActiveChunks::ActiveChunks(int viewDistance) : m_viewDistance(viewDistance)
+{
+	const int viewLength       = (viewDistance * 2) + 1;
+	const int maxVisibleChunks = viewLength * viewLength * viewLength;
+
+	m_chunks.reserve(maxVisibleChunks);
+
+	// the shape of the view never changes, so it's sorted by distance once
+	// and the load queue is built by walking it.
+	m_viewOffsets.reserve(maxVisibleChunks);
+	for (int x = -viewDistance; x <= viewDistance; x++)
+	{
+		for (int y = -viewDistance; y <= viewDistance; y++)
+		{
+			for (int z = -viewDistance; z <= viewDistance; z++)
+			{
+				m_viewOffsets.push_back({x, y, z});
+			}
+		}
+	}
+
+	std::stable_sort(m_viewOffsets.begin(), m_viewOffsets.end(),
+	                 [](const ChunkPos& lhs, const ChunkPos& rhs) {
+		                 return lengthSquared(lhs) < lengthSquared(rhs);
+	                 });
+}
+
+Chunk* ActiveChunks::find(const ChunkPos& pos) const
+{
+	Chunk* const* chunk = m_chunks.find(pos);
+	return chunk != nullptr ? *chunk : nullptr;
+}
+
+bool ActiveChunks::contains(const ChunkPos& pos) const
+{
+	return m_chunks.contains(pos);
+}
+
+void ActiveChunks::add(const ChunkPos& pos, Chunk* chunk)
+{
+	m_chunks[pos] = chunk;
+}
+
+std::size_t ActiveChunks::getBlockIDAt(const BlockPos& position) const
+{
+	const Chunk* chunk = find(toChunkPos(position));
+	if (chunk != nullptr)
+	{
+		return chunk->getBlockIDAt(toLocalPos(position));
+	}
+
+	return BlockRegistry::OUT_OF_BOUNDS_BLOCK;
+}
+
+std::vector<ChunkPos> ActiveChunks::drop(const ChunkPos& center, int margin,
+                                         const CancelCallback& cancel)
+{
+	// the table can't change while it's being walked, so the chunks to
+	// let go of are gathered first.
+	std::vector<ChunkPos> dropped;
+	m_chunks.forEach([this, &center, margin, &cancel, &dropped](
+	                     const ChunkPos& pos, const Chunk*) {
+		if (!isWithin(pos, center, m_viewDistance) &&
+		    (cancel(pos) || !isWithin(pos, center, m_viewDistance + margin)))
+		{
+			dropped.push_back(pos);
+		}
+	});
+
+	for (const ChunkPos& pos : dropped)
+	{
+		m_chunks.erase(pos);
+	}
+
+	return dropped;
+}
+
+void ActiveChunks::rebuildLoadQueue(const ChunkPos&   center,
+                                    const math::vec3& direction)
+{
+	m_queueDirection = direction;
+	m_loadQueue.clear();
+
+	// only the chunks that came into view since the last rebuild (and any
+	// that didn't get loaded in time) are queued, so there's rarely much
+	// to sort.
+	for (const ChunkPos& offset : m_viewOffsets)
+	{
+		if (!m_chunks.contains(center + offset))
+		{
+			m_loadQueue.push_back(offset);
+		}
+	}
+
+	// chunks straight ahead count as a third as far away as the ones
+	// behind, so the ones coming into view are loaded before the ones
+	// behind the player.
+	const auto priority = [&direction](const ChunkPos& offset) {
+		const float distance = std::sqrt(float(lengthSquared(offset)));
+		if (distance == 0.f)
+			return 0.f;
+
+		const math::vec3 heading = {float(offset.x), float(offset.y),
+		                            float(offset.z)};
+		const float      facing =
+		    math::vec3::dotProduct(heading, direction) / distance;
+
+		return distance * (2.f - facing);
+	};
+
+	// the most important go at the back, where they're popped from.
+	std::stable_sort(m_loadQueue.begin(), m_loadQueue.end(),
+	                 [&priority](const ChunkPos& lhs, const ChunkPos& rhs) {
+		                 return priority(lhs) > priority(rhs);
+	                 });
+
+	for (ChunkPos& offset : m_loadQueue)
+	{
+		offset = center + offset;
+	}
+}
+
+void ActiveChunks::forEachEdited(const BlockPos&      position,
+                                 const RemeshCallback& remesh)
+{
+	const ChunkPos chunkPosition = toChunkPos(position);
+	const BlockPos local         = toLocalPos(position);
+
+	// only the section holding the block needs remeshing, plus the one
+	// above or below if the block sits on the boundary between them.
+	const int              height  = gfx::CHUNK_SECTION_HEIGHT;
+	const int              section = local.y / height;
+	const gfx::SectionMask level   = 1u << section;
+
+	gfx::SectionMask sections = level;
+	if (local.y % height == 0 && section > 0)
+		sections |= level >> 1;
+	if (local.y % height == height - 1 &&
+	    section < gfx::CHUNK_SECTION_COUNT - 1)
+		sections |= level << 1;
+
+	remesh(chunkPosition, sections);
+
+	// blocks on the edge of a chunk can hide (or reveal) faces of the
+	// neighbouring chunk too, but only in the section touching the block.
+	if (local.x == 0)
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::LEFT)], level);
+	if (local.x == Chunk::CHUNK_WIDTH - 1)
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::RIGHT)], level);
+	if (local.z == 0)
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::FRONT)], level);
+	if (local.z == Chunk::CHUNK_DEPTH - 1)
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::BACK)], level);
+
+	if (local.y == 0)
+	{
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::BOTTOM)],
+		       1u << (gfx::CHUNK_SECTION_COUNT - 1));
+	}
+	if (local.y == Chunk::CHUNK_HEIGHT - 1)
+	{
+		remesh(chunkPosition + NEIGHBOURS[int(gfx::BlockFace::TOP)], 1u);
+	}
+}
+
+bool ActiveChunks::isWithin(const ChunkPos& pos, const ChunkPos& center,
+                            int distance)
+{
+	const ChunkPos offset = pos - center;
+	return std::abs(offset.x) <= distance && std::abs(offset.y) <= distance &&
+	       std::abs(offset.z) <= distance;
+}
@@ -0,0 +1,126 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Client/Graphics/ArenaAllocator.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace phx;
+using namespace gfx;
+
+ArenaAllocator::ArenaAllocator(std::size_t capacity) { reset(capacity, 0); }
+
+std::size_t ArenaAllocator::allocate(std::size_t size)
+{
+	for (auto it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		if (it->second < size)
+		{
+			continue;
+		}
+
+		const std::size_t offset = it->first;
+		const std::size_t left   = it->second - size;
+
+		// take the front of the gap, so everything stays packed towards
+		// the start of the buffer.
+		m_free.erase(it);
+		if (left != 0)
+		{
+			m_free.emplace(offset + size, left);
+		}
+
+		m_used += size;
+		return offset;
+	}
+
+	return INVALID;
+}
+
+void ArenaAllocator::free(std::size_t offset, std::size_t size)
+{
+	m_used -= size;
+
+	auto next = m_free.lower_bound(offset);
+
+	// merge with the gap straight after.
+	if (next != m_free.end() && next->first == offset + size)
+	{
+		size += next->second;
+		next = m_free.erase(next);
+	}
+
+	// and the one straight before.
+	if (next != m_free.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	m_free.emplace_hint(next, offset, size);
+}
+
+void ArenaAllocator::reset(std::size_t capacity, std::size_t used)
+{
+	m_capacity = capacity;
+	m_used     = used;
+
+	m_free.clear();
+	if (used < capacity)
+	{
+		m_free.emplace(used, capacity - used);
+	}
+}
+
+std::size_t ArenaAllocator::getLargestFreeBlock() const
+{
+	std::size_t largest = 0;
+	for (const auto& block : m_free)
+	{
+		largest = std::max(largest, block.second);
+	}
+
+	return largest;
+}
+
+float ArenaAllocator::getFragmentation() const
+{
+	const std::size_t free = m_capacity - m_used;
+	if (free == 0)
+	{
+		return 0.f;
+	}
+
+	return 1.f - static_cast<float>(getLargestFreeBlock()) /
+	                 static_cast<float>(free);
+}
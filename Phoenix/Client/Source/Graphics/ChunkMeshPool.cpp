@@ -0,0 +1,189 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Client/Graphics/ChunkMeshPool.hpp>
+
+#include <utility>
+
+using namespace phx;
+using namespace gfx;
+
+ChunkMeshPool::ChunkMeshPool(std::size_t                           threads,
+                             const ChunkRenderer::BlockLayerTable& layers)
+    : m_layers(layers)
+{
+	threads = threads == 0 ? 1 : threads;
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		m_threads.emplace_back(&ChunkMeshPool::run, this);
+	}
+}
+
+ChunkMeshPool::~ChunkMeshPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	// anything still queued is dropped, nobody is left to upload it.
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void ChunkMeshPool::submit(voxels::ChunkSnapshot chunk,
+                           const Neighbours& neighbours, MeshingMode mode,
+                           SectionMask sections, bool urgent)
+{
+	const voxels::ChunkPos pos = chunk->getChunkPos();
+
+	// the workers only ever see snapshots, which never change under them.
+	auto job        = std::make_unique<Job>();
+	job->mode       = mode;
+	job->chunk      = std::move(chunk);
+	job->neighbours = neighbours;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// any older job for this chunk is now stale, and is skipped
+		// rather than searched for and removed. This job is newer, so it
+		// can mesh the older job's sections too.
+		Pending& pending = m_latest[pos];
+
+		pending.generation = m_nextGeneration++;
+		pending.sections |= sections;
+
+		job->generation = pending.generation;
+		job->sections   = pending.sections;
+
+		if (urgent)
+		{
+			m_jobs.push_front(std::move(job));
+		}
+		else
+		{
+			m_jobs.push_back(std::move(job));
+		}
+	}
+
+	m_wake.notify_one();
+}
+
+bool ChunkMeshPool::cancel(const voxels::ChunkPos& pos)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_latest.erase(pos);
+}
+
+bool ChunkMeshPool::pop(ChunkMeshResult& result)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	while (!m_finished.empty())
+	{
+		Finished finished = std::move(m_finished.front());
+		m_finished.pop_front();
+
+		// the chunk may have been edited or cancelled since this finished.
+		if (isLatest(finished.result.pos, finished.generation))
+		{
+			m_latest.erase(finished.result.pos);
+			result = std::move(finished.result);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::size_t ChunkMeshPool::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_latest.size();
+}
+
+bool ChunkMeshPool::isLatest(const voxels::ChunkPos& pos,
+                             std::uint64_t           generation) const
+{
+	const Pending* latest = m_latest.find(pos);
+	return latest != nullptr && latest->generation == generation;
+}
+
+void ChunkMeshPool::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+		if (m_stop)
+		{
+			return;
+		}
+
+		std::unique_ptr<Job> job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+
+		const voxels::ChunkPos pos = job->chunk->getChunkPos();
+		if (!isLatest(pos, job->generation))
+		{
+			continue;
+		}
+
+		lock.unlock();
+
+		ChunkMesher mesher(pos, *job->chunk, m_layers);
+		for (std::size_t face = 0; face < job->neighbours.size(); ++face)
+		{
+			mesher.setNeighbour(static_cast<BlockFace>(face),
+			                    job->neighbours[face].get());
+		}
+
+		mesher.mesh(job->mode, job->sections);
+
+		Finished finished {job->generation, {pos, job->sections, {}}};
+		for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+		{
+			finished.result.meshes[section] = mesher.getMesh(section);
+		}
+
+		// drop the snapshots without holding the lock.
+		job.reset();
+
+		lock.lock();
+
+		// skip anything that went stale while it was being meshed, rather
+		// than holding on to it until the next pop().
+		if (isLatest(pos, finished.generation))
+		{
+			m_finished.push_back(std::move(finished));
+		}
+	}
+}
@@ -27,207 +27,491 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <Client/Graphics/ChunkMesher.hpp>
-#include <Common/Voxels/Chunk.hpp>
 
+#include <Common/Voxels/BlockRegistry.hpp>
+
+#include <algorithm>
+
+// the four corners of each face of a unit cube, in BlockFace order. Faces
+// are drawn as indexed quads, so the corners are in the order the shared
+// index buffer expects - see ChunkRenderer::QUAD_INDICES.
 static const phx::math::vec3 CUBE_VERTS[] = {
     // front
     phx::math::vec3(-1.f, -1.f, -1.f), phx::math::vec3(1.f, -1.f, -1.f),
-    phx::math::vec3(1.f, 1.f, -1.f), phx::math::vec3(1.f, 1.f, -1.f),
-    phx::math::vec3(-1.f, 1.f, -1.f), phx::math::vec3(-1.f, -1.f, -1.f),
+    phx::math::vec3(1.f, 1.f, -1.f), phx::math::vec3(-1.f, 1.f, -1.f),
 
-	// left
+    // left
     phx::math::vec3(-1.f, 1.f, 1.f), phx::math::vec3(-1.f, 1.f, -1.f),
-    phx::math::vec3(-1.f, -1.f, -1.f), phx::math::vec3(-1.f, -1.f, -1.f),
-    phx::math::vec3(-1.f, -1.f, 1.f), phx::math::vec3(-1.f, 1.f, 1.f),
+    phx::math::vec3(-1.f, -1.f, -1.f), phx::math::vec3(-1.f, -1.f, 1.f),
 
     // back
     phx::math::vec3(-1.f, -1.f, 1.f), phx::math::vec3(1.f, -1.f, 1.f),
-    phx::math::vec3(1.f, 1.f, 1.f), phx::math::vec3(1.f, 1.f, 1.f),
-    phx::math::vec3(-1.f, 1.f, 1.f), phx::math::vec3(-1.f, -1.f, 1.f),
+    phx::math::vec3(1.f, 1.f, 1.f), phx::math::vec3(-1.f, 1.f, 1.f),
 
     // right
     phx::math::vec3(1.f, 1.f, 1.f), phx::math::vec3(1.f, 1.f, -1.f),
-    phx::math::vec3(1.f, -1.f, -1.f), phx::math::vec3(1.f, -1.f, -1.f),
-    phx::math::vec3(1.f, -1.f, 1.f), phx::math::vec3(1.f, 1.f, 1.f),
+    phx::math::vec3(1.f, -1.f, -1.f), phx::math::vec3(1.f, -1.f, 1.f),
 
-	// top
+    // top
     phx::math::vec3(-1.f, 1.f, -1.f), phx::math::vec3(1.f, 1.f, -1.f),
-    phx::math::vec3(1.f, 1.f, 1.f), phx::math::vec3(1.f, 1.f, 1.f),
-    phx::math::vec3(-1.f, 1.f, 1.f), phx::math::vec3(-1.f, 1.f, -1.f),
+    phx::math::vec3(1.f, 1.f, 1.f), phx::math::vec3(-1.f, 1.f, 1.f),
 
     // bottom
     phx::math::vec3(-1.f, -1.f, -1.f), phx::math::vec3(1.f, -1.f, -1.f),
-    phx::math::vec3(1.f, -1.f, 1.f), phx::math::vec3(1.f, -1.f, 1.f),
-    phx::math::vec3(-1.f, -1.f, 1.f), phx::math::vec3(-1.f, -1.f, -1.f),
+    phx::math::vec3(1.f, -1.f, 1.f), phx::math::vec3(-1.f, -1.f, 1.f),
 };
 
-static const phx::math::vec2 CUBE_UV[] = {
-    // front north
-    phx::math::vec2(-0.f, 1.f),
-    phx::math::vec2(-1.f, 1.f),
-    phx::math::vec2(-1.f, 0.f),
-    phx::math::vec2(-1.f, 0.f),
-    phx::math::vec2(-0.f, 0.f),
-    phx::math::vec2(-0.f, 1.f),
-
-	// left west
-    phx::math::vec2(-0.f, 0.f),
-    phx::math::vec2(-1.f, 0.f),
-    phx::math::vec2(-1.f, 1.f),
-    phx::math::vec2(-1.f, 1.f),
-    phx::math::vec2(-0.f, 1.f),
-    phx::math::vec2(-0.f, 0.f),
-
-    // back south
-    phx::math::vec2(0.f, 1.f),
-    phx::math::vec2(1.f, 1.f),
-    phx::math::vec2(1.f, 0.f),
-    phx::math::vec2(1.f, 0.f),
-    phx::math::vec2(0.f, 0.f),
-    phx::math::vec2(0.f, 1.f),
-
-	// right east
-    phx::math::vec2(0.f, 0.f),
-    phx::math::vec2(1.f, 0.f),
-    phx::math::vec2(1.f, 1.f),
-    phx::math::vec2(1.f, 1.f),
-    phx::math::vec2(0.f, 1.f),
-    phx::math::vec2(0.f, 0.f),
+const int NUM_FACES_IN_CUBE = 6;
 
-    // top
-    phx::math::vec2(0.f, -1.f),
-    phx::math::vec2(1.f, -1.f),
-    phx::math::vec2(1.f, -0.f),
-    phx::math::vec2(1.f, -0.f),
-    phx::math::vec2(0.f, -0.f),
-    phx::math::vec2(0.f, -1.f),
+// the axes (0 = x, 1 = y, 2 = z) each face is laid across, in BlockFace
+// order. "u" and "v" are the axes the face's texture runs along, and
+// "normal" is the axis the face points along, towards "direction".
+struct FaceAxes
+{
+	int normal;
+	int direction;
+	int u;
+	int v;
+};
 
-    // bottom
-    phx::math::vec2(0.f, 1.f),
-    phx::math::vec2(1.f, 1.f),
-    phx::math::vec2(1.f, 0.f),
-    phx::math::vec2(1.f, 0.f),
-    phx::math::vec2(0.f, 0.f),
-    phx::math::vec2(0.f, 1.f),
+static const FaceAxes FACE_AXES[] = {
+    {2, -1, 0, 1}, // front
+    {0, -1, 2, 1}, // left
+    {2, 1, 0, 1},  // back
+    {0, 1, 2, 1},  // right
+    {1, 1, 0, 2},  // top
+    {1, -1, 0, 2}, // bottom
 };
 
-const int ACTUAL_CUBE_SIZE  = 2;
-const int NUM_FACES_IN_CUBE = 6;
-const int NUM_VERTS_IN_FACE = 6;
+static_assert(phx::voxels::Chunk::CHUNK_WIDTH ==
+                      phx::voxels::Chunk::CHUNK_HEIGHT &&
+                  phx::voxels::Chunk::CHUNK_WIDTH ==
+                      phx::voxels::Chunk::CHUNK_DEPTH,
+              "The mesher expects cubic chunks.");
+
+static_assert(phx::gfx::ChunkRenderer::MAX_TEXTURE_LAYERS <= 1 << 8,
+              "A ChunkVertex only has 8 bits for the texture layer.");
+
+const int CHUNK_SIZE = phx::voxels::Chunk::CHUNK_WIDTH;
+
+// the chunk plus a one block border taken from its neighbours.
+const int PADDED_SIZE      = CHUNK_SIZE + 2;
+const int PADDED_STRIDE[3] = {1, PADDED_SIZE, PADDED_SIZE * PADDED_SIZE};
+
+static int paddedIndex(int x, int y, int z)
+{
+	return (x + 1) + PADDED_SIZE * ((y + 1) + PADDED_SIZE * (z + 1));
+}
+
+// the rows (y) covered by a set of sections, "last" is one past the end.
+static void sectionRows(phx::gfx::SectionMask sections, int& first, int& last)
+{
+	using namespace phx::gfx;
+
+	first = CHUNK_SIZE;
+	last  = 0;
+	for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+	{
+		if ((sections & (1u << section)) != 0)
+		{
+			first = std::min(first, section * CHUNK_SECTION_HEIGHT);
+			last  = std::max(last, (section + 1) * CHUNK_SECTION_HEIGHT);
+		}
+	}
+}
 
 using namespace phx;
 using namespace gfx;
 
-void ChunkMesher::mesh()
+void ChunkMesher::setNeighbour(BlockFace face, const voxels::Chunk* neighbour)
+{
+	m_neighbours[static_cast<std::size_t>(face)] = neighbour;
+}
+
+bool ChunkMesher::canSkip() const
 {
 	using namespace voxels;
-	for (std::size_t i = 0;
-	     i < Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT * Chunk::CHUNK_DEPTH; ++i)
+
+	if (!m_chunk.isUniform())
 	{
-		BlockType* block = m_blockRef[i];
+		return false;
+	}
 
-		if (block->category != BlockCategory::SOLID)
-			continue;
+	const BlockProperties& properties = BlockRegistry::get()->getProperties();
 
-		const std::size_t x = i % Chunk::CHUNK_WIDTH;
-		const std::size_t y = (i / Chunk::CHUNK_WIDTH) % Chunk::CHUNK_HEIGHT;
-		const std::size_t z = i / (Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT);
-
-		if (x == 0 ||
-		    m_blockRef[Chunk::getVectorIndex(x - 1, y, z)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::LEFT, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
-		if (x == Chunk::CHUNK_WIDTH - 1 ||
-		    m_blockRef[Chunk::getVectorIndex(x + 1, y, z)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::RIGHT, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
-
-		if (y == 0 ||
-		    m_blockRef[Chunk::getVectorIndex(x, y - 1, z)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::BOTTOM, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
-		if (y == Chunk::CHUNK_WIDTH - 1 ||
-		    m_blockRef[Chunk::getVectorIndex(x, y + 1, z)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::TOP, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
-
-		if (z == 0 ||
-		    m_blockRef[Chunk::getVectorIndex(x, y, z - 1)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::FRONT, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
-		if (z == Chunk::CHUNK_DEPTH - 1 ||
-		    m_blockRef[Chunk::getVectorIndex(x, y, z + 1)]->category !=
-		        BlockCategory::SOLID)
-			addBlockFace(block, BlockFace::BACK, static_cast<float>(x),
-			             static_cast<float>(y), static_cast<float>(z));
+	// only opaque blocks produce faces.
+	if (!properties.isOpaque(m_chunk.getBlocks().getPalette()[0]))
+	{
+		return true;
 	}
+
+	// an opaque chunk is only visible through a neighbour that isn't.
+	for (const Chunk* neighbour : m_neighbours)
+	{
+		if (neighbour == nullptr || !neighbour->isUniform() ||
+		    !properties.isOpaque(neighbour->getBlocks().getPalette()[0]))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-void ChunkMesher::addBlockFace(voxels::BlockType* block, BlockFace face,
-                               float x, float y, float z)
+void ChunkMesher::mesh(MeshingMode mode, SectionMask sections)
 {
-	const std::size_t texLayer = m_texTable.at(block->textures[static_cast<std::size_t>(face)]);
+	using namespace voxels;
 
-	math::vec3 normals;
-	switch (face)
+	if (canSkip())
 	{
-		case BlockFace::FRONT:
-			normals = math::vec3(0, 0, -1);
-			break;
+		return;
+	}
+
+	// resolve the chunk's palette up front, so every lookup in the loop is
+	// just an unpack and an array index.
+	const BlockProperties& properties = BlockRegistry::get()->getProperties();
+	const BlockStorage&    blocks     = m_chunk.getBlocks();
 
-		case BlockFace::LEFT:
-			normals = math::vec3(-1, 0, 0);
-			break;
+	std::vector<PaletteEntry> palette;
+	for (std::size_t id : blocks.getPalette())
+	{
+		PaletteEntry entry {properties.isOpaque(id), properties.getColor(id),
+		                    {}};
 
-		case BlockFace::BACK:
-			normals = math::vec3(0, 0, 1);
-			break;
+		if (entry.opaque && id < m_layers.size())
+		{
+			std::copy(m_layers[id].begin(), m_layers[id].end(),
+			          entry.layers.begin());
+		}
 
-		case BlockFace::RIGHT:
-			normals = math::vec3(1, 0, 0);
-			break;
+		palette.push_back(entry);
+	}
 
-		case BlockFace::TOP:
-			normals = math::vec3(0, 1, 0);
-			break;
+	const std::vector<std::uint8_t> opaque = buildOpacity(palette, sections);
 
-		case BlockFace::BOTTOM:
-			normals = math::vec3(0, -1, 0);
-			break;
+	if (mode == MeshingMode::GREEDY)
+	{
+		meshGreedy(palette, opaque, sections);
 	}
+	else
+	{
+		meshNaive(palette, opaque, sections);
+	}
+}
+
+std::vector<std::uint8_t> ChunkMesher::buildOpacity(
+    const std::vector<PaletteEntry>& palette, SectionMask sections) const
+{
+	using namespace voxels;
 
-	for (int i = 0; i < NUM_VERTS_IN_FACE; ++i)
+	const BlockProperties& properties = BlockRegistry::get()->getProperties();
+	const BlockStorage&    blocks     = m_chunk.getBlocks();
+
+	std::vector<std::uint8_t> opaque(
+	    PADDED_SIZE * PADDED_SIZE * PADDED_SIZE, 0);
+
+	// only the rows being meshed and the ones either side of them are
+	// ever looked at, so remeshing one section stays cheap.
+	int first;
+	int last;
+	sectionRows(sections, first, last);
+
+	const int lower[3] = {0, std::max(first - 1, 0), 0};
+	const int upper[3] = {CHUNK_SIZE, std::min(last + 1, CHUNK_SIZE),
+	                      CHUNK_SIZE};
+
+	for (int z = 0; z < CHUNK_SIZE; ++z)
+	{
+		for (int y = lower[1]; y < upper[1]; ++y)
+		{
+			for (int x = 0; x < CHUNK_SIZE; ++x)
+			{
+				opaque[paddedIndex(x, y, z)] =
+				    palette[blocks.getPaletteIndex(
+				                Chunk::getVectorIndex(x, y, z))]
+				        .opaque;
+			}
+		}
+	}
+
+	// copy in the layer of each neighbour touching this chunk. Without a
+	// neighbour the border stays transparent, so the faces are kept.
+	for (int f = 0; f < NUM_FACES_IN_CUBE; ++f)
+	{
+		const Chunk* neighbour = m_neighbours[f];
+		if (neighbour == nullptr)
+		{
+			continue;
+		}
+
+		const FaceAxes&     axes    = FACE_AXES[f];
+		const BlockStorage& storage = neighbour->getBlocks();
+
+		int border[3];
+		int source[3];
+		border[axes.normal] = axes.direction > 0 ? CHUNK_SIZE : -1;
+		source[axes.normal] = axes.direction > 0 ? 0 : CHUNK_SIZE - 1;
+
+		// the chunks above and below only matter if the sections being
+		// meshed touch them.
+		if (axes.normal == 1 && (border[1] < first - 1 || border[1] > last))
+		{
+			continue;
+		}
+
+		for (int v = lower[axes.v]; v < upper[axes.v]; ++v)
+		{
+			for (int u = lower[axes.u]; u < upper[axes.u]; ++u)
+			{
+				border[axes.u] = source[axes.u] = u;
+				border[axes.v] = source[axes.v] = v;
+
+				opaque[paddedIndex(border[0], border[1], border[2])] =
+				    properties.isOpaque(storage.get(Chunk::getVectorIndex(
+				        source[0], source[1], source[2])));
+			}
+		}
+	}
+
+	return opaque;
+}
+
+void ChunkMesher::meshNaive(const std::vector<PaletteEntry>& palette,
+                            const std::vector<std::uint8_t>& opaque,
+                            SectionMask                      sections)
+{
+	using namespace voxels;
+
+	const BlockStorage& blocks = m_chunk.getBlocks();
+
+	for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
 	{
-		math::vec3 blockVertices = CUBE_VERTS[(static_cast<int>(face) * NUM_FACES_IN_CUBE) + i];
-		blockVertices.x += (x * ACTUAL_CUBE_SIZE) + (m_pos.x * ACTUAL_CUBE_SIZE);
-		blockVertices.y += (y * ACTUAL_CUBE_SIZE) + (m_pos.y * ACTUAL_CUBE_SIZE);
-		blockVertices.z += (z * ACTUAL_CUBE_SIZE) + (m_pos.z * ACTUAL_CUBE_SIZE);
+		if ((sections & (1u << section)) == 0)
+			continue;
 
-		math::vec2 cubeUVs = CUBE_UV[(static_cast<int>(face) * NUM_FACES_IN_CUBE) + i];
+		const int bottom = section * CHUNK_SECTION_HEIGHT;
+
+		for (int z = 0; z < CHUNK_SIZE; ++z)
+		{
+			for (int y = bottom; y < bottom + CHUNK_SECTION_HEIGHT; ++y)
+			{
+				for (int x = 0; x < CHUNK_SIZE; ++x)
+				{
+					const PaletteEntry& block = palette[blocks.getPaletteIndex(
+					    Chunk::getVectorIndex(x, y, z))];
+
+					if (!block.opaque)
+						continue;
+
+					const BlockPos pos    = {x, y, z};
+					const int      padded = paddedIndex(x, y, z);
+
+					if (!opaque[padded - PADDED_STRIDE[0]])
+						addQuad(section, block, BlockFace::LEFT, pos, 1, 1);
+					if (!opaque[padded + PADDED_STRIDE[0]])
+						addQuad(section, block, BlockFace::RIGHT, pos, 1, 1);
+
+					if (!opaque[padded - PADDED_STRIDE[1]])
+						addQuad(section, block, BlockFace::BOTTOM, pos, 1, 1);
+					if (!opaque[padded + PADDED_STRIDE[1]])
+						addQuad(section, block, BlockFace::TOP, pos, 1, 1);
+
+					if (!opaque[padded - PADDED_STRIDE[2]])
+						addQuad(section, block, BlockFace::FRONT, pos, 1, 1);
+					if (!opaque[padded + PADDED_STRIDE[2]])
+						addQuad(section, block, BlockFace::BACK, pos, 1, 1);
+				}
+			}
+		}
+	}
+}
 
-		m_mesh.push_back(blockVertices.x);
-		m_mesh.push_back(blockVertices.y);
-		m_mesh.push_back(blockVertices.z);
+void ChunkMesher::meshGreedy(const std::vector<PaletteEntry>& palette,
+                             const std::vector<std::uint8_t>& opaque,
+                             SectionMask                      sections)
+{
+	using namespace voxels;
 
-		m_mesh.push_back(cubeUVs.x);
-		m_mesh.push_back(cubeUVs.y);
+	constexpr int SIZE      = CHUNK_SIZE;
+	constexpr int STRIDE[3] = {1, SIZE, SIZE * SIZE};
 
-		m_mesh.push_back(static_cast<float>(texLayer));
+	// unpack every index being meshed once, each block is looked at up to
+	// 6 times.
+	int first;
+	int last;
+	sectionRows(sections, first, last);
 
-		m_mesh.push_back(normals.x);
-		m_mesh.push_back(normals.y);
-		m_mesh.push_back(normals.z);
+	const BlockStorage&        blocks = m_chunk.getBlocks();
+	std::vector<std::uint16_t> indices(blocks.size());
+	for (int z = 0; z < SIZE; ++z)
+	{
+		for (int y = first; y < last; ++y)
+		{
+			for (int x = 0; x < SIZE; ++x)
+			{
+				const std::size_t index = Chunk::getVectorIndex(x, y, z);
+				indices[index] =
+				    static_cast<std::uint16_t>(blocks.getPaletteIndex(index));
+			}
+		}
+	}
 
-		m_mesh.push_back(block->color);
+	// faces can only be merged if they'd look identical, so faces are
+	// keyed by their texture layer and color - 0 is reserved for "no
+	// visible face".
+	std::vector<std::array<std::uint64_t, 6>> keys(palette.size());
+	for (std::size_t i = 0; i < palette.size(); ++i)
+	{
+		for (std::size_t f = 0; f < keys[i].size(); ++f)
+		{
+			const std::uint64_t layer = palette[i].layers[f];
+			keys[i][f] = ((layer << 16) | palette[i].color) + 1;
+		}
+	}
+
+	std::array<std::uint64_t, SIZE * SIZE> mask;
+	std::array<std::uint16_t, SIZE * SIZE> entries;
+
+	for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+	{
+		if ((sections & (1u << section)) == 0)
+			continue;
 
-		// m_mesh.push_back(x);
-		// m_mesh.push_back(y);
-		// m_mesh.push_back(z);
+		// faces are never merged across sections, so each one can be
+		// remeshed on its own.
+		const int lower[3] = {0, section * CHUNK_SECTION_HEIGHT, 0};
+		const int upper[3] = {SIZE, lower[1] + CHUNK_SECTION_HEIGHT, SIZE};
+
+		for (int f = 0; f < NUM_FACES_IN_CUBE; ++f)
+		{
+			const FaceAxes& axes = FACE_AXES[f];
+			const BlockFace face = static_cast<BlockFace>(f);
+
+			const int uEnd = upper[axes.u];
+			const int vEnd = upper[axes.v];
+
+			// the block in front of a face, in the padded opacity grid.
+			const int facing = axes.direction * PADDED_STRIDE[axes.normal];
+
+			for (int slice = lower[axes.normal]; slice < upper[axes.normal];
+			     ++slice)
+			{
+				int pos[3];
+				pos[axes.normal] = slice;
+
+				for (int v = lower[axes.v]; v < vEnd; ++v)
+				{
+					for (int u = lower[axes.u]; u < uEnd; ++u)
+					{
+						pos[axes.u] = u;
+						pos[axes.v] = v;
+
+						const int index = pos[0] * STRIDE[0] +
+						                  pos[1] * STRIDE[1] +
+						                  pos[2] * STRIDE[2];
+						const int padded =
+						    paddedIndex(pos[0], pos[1], pos[2]);
+
+						const bool visible =
+						    opaque[padded] && !opaque[padded + facing];
+
+						mask[v * SIZE + u] =
+						    visible ? keys[indices[index]][f] : 0;
+						entries[v * SIZE + u] = indices[index];
+					}
+				}
+
+				// grow each face as wide as it can go, then as tall as
+				// every face across that width allows.
+				for (int v = lower[axes.v]; v < vEnd; ++v)
+				{
+					for (int u = lower[axes.u]; u < uEnd;)
+					{
+						const std::uint64_t key = mask[v * SIZE + u];
+						if (key == 0)
+						{
+							++u;
+							continue;
+						}
+
+						int width = 1;
+						while (u + width < uEnd &&
+						       mask[v * SIZE + u + width] == key)
+						{
+							++width;
+						}
+
+						int  height = 1;
+						bool grow   = true;
+						while (grow && v + height < vEnd)
+						{
+							for (int i = 0; i < width; ++i)
+							{
+								if (mask[(v + height) * SIZE + u + i] != key)
+								{
+									grow = false;
+									break;
+								}
+							}
+
+							if (grow)
+							{
+								++height;
+							}
+						}
+
+						for (int j = 0; j < height; ++j)
+						{
+							for (int i = 0; i < width; ++i)
+							{
+								mask[(v + j) * SIZE + u + i] = 0;
+							}
+						}
+
+						pos[axes.u] = u;
+						pos[axes.v] = v;
+						addQuad(section, palette[entries[v * SIZE + u]], face,
+						        {pos[0], pos[1], pos[2]}, width, height);
+
+						u += width;
+					}
+				}
+			}
+		}
 	}
 }
 
+void ChunkMesher::addQuad(int section, const PaletteEntry& block,
+                          BlockFace face, const voxels::BlockPos& pos,
+                          int width, int height)
+{
+	const FaceAxes& axes = FACE_AXES[static_cast<int>(face)];
+
+	// how many blocks the quad covers along each axis.
+	int extent[3]  = {1, 1, 1};
+	extent[axes.u] = width;
+	extent[axes.v] = height;
+
+	const int start[3] = {pos.x, pos.y, pos.z};
+
+	// everything but the position is the same for the whole quad.
+	const std::uint32_t attributes =
+	    (static_cast<std::uint32_t>(face) << 15) |
+	    (static_cast<std::uint32_t>(block.layers[static_cast<int>(face)])
+	     << 18);
+
+	for (int i = 0; i < VERTICES_PER_QUAD; ++i)
+	{
+		const math::vec3& cubeVertex =
+		    CUBE_VERTS[(static_cast<int>(face) * VERTICES_PER_QUAD) + i];
+
+		// stretch the unit cube's corners out over every block the quad
+		// covers - these are block corners, so they run from 0 to 16.
+		const std::uint32_t x = start[0] + (cubeVertex.x > 0.f ? extent[0] : 0);
+		const std::uint32_t y = start[1] + (cubeVertex.y > 0.f ? extent[1] : 0);
+		const std::uint32_t z = start[2] + (cubeVertex.z > 0.f ? extent[2] : 0);
+
+		m_meshes[section].push_back(
+		    {x | (y << 5) | (z << 10) | attributes, block.color});
+	}
+}
@@ -35,48 +35,75 @@
 #include <glad/glad.h>
 #include <stb_image.h>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace phx;
 using namespace gfx;
 
-// struct to help with laying out the data inside the buffers.
-struct Vertex
-{
-	float x;
-	float y;
-	float z;
-	float u;
-	float v;
-	float tex;
-	float norm_x;
-	float norm_y;
-	float norm_z;
-	unsigned color;
-	// float pos_x;
-	// float pos_y;
-	// float pos_z;
-};
+// how many vertices share an entry in the origin buffer. Sections are
+// reserved whole granules at a time, so every granule belongs to a single
+// chunk. This must match SimpleWorld.vert.
+static const std::size_t ARENA_GRANULE = 64;
+
+// the arena starts with room for a million vertices (8 MiB), and doubles
+// whenever it runs out.
+static const std::size_t ARENA_INITIAL_GRANULES = 16384;
 
 ChunkRenderer::ChunkRenderer(const std::size_t visibleChunks)
+    : m_arena(ARENA_INITIAL_GRANULES)
 {
 	m_buffers.reserve(visibleChunks);
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	// every quad is drawn the same way, so one index buffer big enough for
+	// the fullest possible section is shared by all of them.
+	std::vector<std::uint16_t> indices;
+	indices.reserve(MAX_QUADS_PER_SECTION * INDICES_PER_QUAD);
+	for (int quad = 0; quad < MAX_QUADS_PER_SECTION; ++quad)
+	{
+		for (std::uint16_t index : QUAD_INDICES)
+		{
+			indices.push_back(
+			    static_cast<std::uint16_t>(quad * VERTICES_PER_QUAD + index));
+		}
+	}
+
+	glGenBuffers(1, &m_quadIndices);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadIndices);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+	             sizeof(std::uint16_t) * indices.size(), indices.data(),
+	             GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_arenaBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_arenaBuffer);
+	glBufferData(GL_ARRAY_BUFFER,
+	             sizeof(ChunkVertex) * ARENA_GRANULE * m_arena.getCapacity(),
+	             nullptr, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &m_originBuffer);
+	glGenTextures(1, &m_originTexture);
+	m_origins.assign(m_arena.getCapacity() * 4, 0);
+
+	bindArena();
 }
 
 ChunkRenderer::~ChunkRenderer()
 {
-	for (auto& buffer : m_buffers)
-	{
-		glDeleteBuffers(1, &buffer.second.buffer);
-		glDeleteVertexArrays(1, &buffer.second.vao);
-	}
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_arenaBuffer);
+	glDeleteBuffers(1, &m_quadIndices);
+	glDeleteTextures(1, &m_originTexture);
+	glDeleteBuffers(1, &m_originBuffer);
 }
 
 std::vector<ShaderLayout> ChunkRenderer::getRequiredShaderLayout()
 {
 	std::vector<ShaderLayout> layout;
-	layout.emplace_back("a_Vertex", 0);
-	layout.emplace_back("a_UV", 1);
+	layout.emplace_back("a_Data", 0);
+	layout.emplace_back("a_Color", 1);
 
 	return layout;
 }
@@ -86,15 +113,33 @@ void ChunkRenderer::buildTextureArray()
 	glGenTextures(1, &m_textureArray);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
 
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 16, 16, 256, 0, GL_RGBA,
-	             GL_UNSIGNED_BYTE, nullptr);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 16, 16, MAX_TEXTURE_LAYERS,
+	             0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
 	std::vector<std::string> texturePaths =
 	    voxels::BlockRegistry::get()->getTextures()->getTextures();
 
+	// the layer each texture ended up on, by TextureRegistry index. Missing
+	// textures fall back to the first layer rather than crashing the
+	// mesher.
+	std::vector<std::uint16_t> textureLayers(texturePaths.size(), 0);
+
 	std::size_t i = 0;
-	for (std::string& path : texturePaths)
+	for (std::size_t texture = 0; texture < texturePaths.size(); ++texture)
 	{
+		const std::string& path = texturePaths[texture];
+
+		// the mesher packs the layer into 8 bits, so anything past the end
+		// of the array would wrap around onto another texture.
+		if (i >= MAX_TEXTURE_LAYERS)
+		{
+			std::cout << "[RENDERING][TEXTURES] The file: " << path
+			          << " doesn't fit in the texture array, only "
+			          << MAX_TEXTURE_LAYERS << " textures can be loaded."
+			          << std::endl;
+			continue;
+		}
+
 		int            width = -1, height = -1, nbChannels = -1;
 		unsigned char* image =
 		    stbi_load(path.c_str(), &width, &height, &nbChannels, 0);
@@ -105,6 +150,7 @@ void ChunkRenderer::buildTextureArray()
 			                GL_UNSIGNED_BYTE, image);
 
 			m_textureTable.insert({path, i});
+			textureLayers[texture] = static_cast<std::uint16_t>(i);
 			++i;
 		}
 		else
@@ -116,6 +162,26 @@ void ChunkRenderer::buildTextureArray()
 		stbi_image_free(image);
 	}
 
+	// bake the layers of every block's faces, so meshing a block is an
+	// index into this rather than a string lookup per face.
+	const voxels::BlockProperties& properties =
+	    voxels::BlockRegistry::get()->getProperties();
+
+	m_blockLayers.assign(properties.size(), {});
+	for (std::size_t id = 0; id < properties.size(); ++id)
+	{
+		const voxels::BlockProperties::FaceTextures& textures =
+		    properties.getTextures(id);
+
+		for (std::size_t face = 0; face < textures.size(); ++face)
+		{
+			if (textures[face] != voxels::BlockProperties::NO_TEXTURE)
+			{
+				m_blockLayers[id][face] = textureLayers[textures[face]];
+			}
+		}
+	}
+
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -128,95 +194,319 @@ const ChunkRenderer::AssociativeTextureTable& ChunkRenderer::getTextureTable()
 	return m_textureTable;
 }
 
-void ChunkRenderer::submitChunk(const std::vector<float>& mesh, math::vec3 pos)
+const ChunkRenderer::BlockLayerTable& ChunkRenderer::getBlockLayers() const
+{
+	return m_blockLayers;
+}
+
+void ChunkRenderer::submitChunk(const std::vector<ChunkVertex>& mesh,
+                                voxels::ChunkPos pos, int section)
 {
 	if (mesh.empty())
 	{
 		return;
 	}
 
-	unsigned int vao;
-	unsigned int buf;
+	upload(mesh, pos, m_buffers[pos][section]);
+}
 
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+void ChunkRenderer::updateChunk(const std::vector<ChunkVertex>& mesh,
+                                voxels::ChunkPos pos, int section)
+{
+	SectionRenderData* sections = m_buffers.find(pos);
+	if (sections == nullptr)
+	{
+		submitChunk(mesh, pos, section);
+		return;
+	}
 
-	glGenBuffers(1, &buf);
-	glBindBuffer(GL_ARRAY_BUFFER, buf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.size(), mesh.data(),
-	             GL_DYNAMIC_DRAW);
+	upload(mesh, pos, (*sections)[section]);
+}
+
+void ChunkRenderer::dropChunk(voxels::ChunkPos pos)
+{
+	SectionRenderData* sections = m_buffers.find(pos);
+	if (sections == nullptr)
+	{
+		return;
+	}
 
-	glVertexAttribPointer(m_vertexAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, x)));
+	for (ChunkRenderData& data : *sections)
+	{
+		release(data);
+	}
 
-	// we're gonna pack texLayer into this cos why not.
-	glVertexAttribPointer(m_uvAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, u)));
+	m_buffers.erase(pos);
+}
 
-	glVertexAttribPointer(m_normalAttributeLocation, 3, GL_FLOAT, GL_TRUE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, norm_x)));
+void ChunkRenderer::render(const math::mat4& viewProjection)
+{
+	m_drawList.clear();
+	m_drawBounds.clear();
 
-	glVertexAttribPointer(m_colorAttributeLocation, 1, GL_UNSIGNED_INT, GL_FALSE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, color)));
+	// blocks are 2 units wide and centered on (block * 2), the same as in
+	// the shader.
+	m_buffers.forEach([this](const voxels::ChunkPos&  pos,
+	                         const SectionRenderData& sections) {
+		const voxels::BlockPos origin = voxels::toBlockPos(pos);
 
-	// glVertexAttribPointer(m_posAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-	//                       sizeof(Vertex),
-	//                       reinterpret_cast<void*>(offsetof(Vertex, pos_x)));
+		for (int section = 0; section < CHUNK_SECTION_COUNT; ++section)
+		{
+			const ChunkRenderData& data = sections[section];
+			if (data.vertexCount == 0)
+			{
+				continue;
+			}
+
+			const float bottom =
+			    static_cast<float>(origin.y + section * CHUNK_SECTION_HEIGHT);
+
+			const math::vec3 min = {origin.x * 2.f - 1.f, bottom * 2.f - 1.f,
+			                        origin.z * 2.f - 1.f};
+			const math::vec3 max = {
+			    min.x + voxels::Chunk::CHUNK_WIDTH * 2.f,
+			    min.y + CHUNK_SECTION_HEIGHT * 2.f,
+			    min.z + voxels::Chunk::CHUNK_DEPTH * 2.f};
+
+			m_drawList.push_back(&data);
+			m_drawBounds.push(min, max);
+		}
+	});
+
+	const math::Frustum frustum(viewProjection);
+	m_stats.drawn  = frustum.intersects(m_drawBounds, m_drawVisible);
+	m_stats.culled = m_drawList.size() - m_stats.drawn;
+
+	const std::size_t granuleSize = sizeof(ChunkVertex) * ARENA_GRANULE;
+	m_stats.arenaCapacity         = m_arena.getCapacity() * granuleSize;
+	m_stats.arenaReserved         = m_arena.getUsed() * granuleSize;
+	m_stats.arenaUsed             = m_vertexCount * sizeof(ChunkVertex);
+	m_stats.arenaFreeBlocks       = m_arena.getFreeBlockCount();
+	m_stats.arenaFragmentation    = m_arena.getFragmentation();
+
+	m_drawCounts.clear();
+	m_drawBaseVertices.clear();
+	for (std::size_t i = 0; i < m_drawList.size(); ++i)
+	{
+		if (m_drawVisible[i])
+		{
+			const ChunkRenderData& data = *m_drawList[i];
 
-	glEnableVertexAttribArray(m_vertexAttributeLocation);
-	glEnableVertexAttribArray(m_uvAttributeLocation);
-	glEnableVertexAttribArray(m_normalAttributeLocation);
-	glEnableVertexAttribArray(m_colorAttributeLocation);
-	// glEnableVertexAttribArray(m_posAttributeLocation);
+			m_drawCounts.push_back(static_cast<int>(
+			    data.vertexCount / VERTICES_PER_QUAD * INDICES_PER_QUAD));
+			m_drawBaseVertices.push_back(static_cast<int>(data.first));
+		}
+	}
 
-	m_buffers.insert({pos, {vao, buf, mesh.size()}});
+	if (m_drawCounts.empty())
+	{
+		return;
+	}
+
+	// every section indexes the shared quad indices from the start, the
+	// base vertex is what moves each one to its own range of the arena.
+	m_drawOffsets.assign(m_drawCounts.size(), nullptr);
+
+	// each vertex finds the origin of its chunk in the origin texture, so
+	// nothing needs to change between sections.
+	int program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glUniform1i(glGetUniformLocation(program, "u_chunkOrigins"), 1);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+
+	glBindVertexArray(m_vao);
+	glMultiDrawElementsBaseVertex(
+	    GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_SHORT,
+	    m_drawOffsets.data(), static_cast<GLsizei>(m_drawCounts.size()),
+	    m_drawBaseVertices.data());
 }
 
-void ChunkRenderer::updateChunk(const std::vector<float>& mesh, math::vec3 pos)
+const ChunkRenderStats& ChunkRenderer::getStats() const { return m_stats; }
+
+void ChunkRenderer::upload(const std::vector<ChunkVertex>& mesh,
+                           voxels::ChunkPos pos, ChunkRenderData& data)
 {
-	const auto it = m_buffers.find(pos);
-	if (it == m_buffers.end())
+	if (mesh.empty())
 	{
-		submitChunk(mesh, pos);
+		release(data);
 		return;
 	}
 
-	glBindVertexArray(it->second.vao);
-	glBindBuffer(GL_ARRAY_BUFFER, it->second.buffer);
+	const std::size_t granules =
+	    (mesh.size() + ARENA_GRANULE - 1) / ARENA_GRANULE;
+	const std::size_t reserved = data.capacity / ARENA_GRANULE;
 
-	// If the amount of vertices are the same, then it's actually more
-	// efficient to just sub the data. glBufferData does a "re-alloc then
-	// copy" - effectively the equivalent of std::vector::clear() then
-	// filling it with data. glBufferSubData is more like std::vector::[i] =
-	// blah.
-	if (mesh.size() == it->second.vertexCount)
+	// keep the section where it is if it still fits, unless it's shrunk
+	// enough to give half of its range back.
+	if (granules > reserved || granules * 2 <= reserved)
 	{
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * mesh.size(),
-		                mesh.data());
+		release(data);
+
+		const std::size_t offset = allocate(granules);
+		data.first               = offset * ARENA_GRANULE;
+		data.capacity            = granules * ARENA_GRANULE;
+
+		const voxels::BlockPos origin = voxels::toBlockPos(pos);
+		for (std::size_t granule = offset; granule < offset + granules;
+		     ++granule)
+		{
+			m_origins[granule * 4]     = origin.x;
+			m_origins[granule * 4 + 1] = origin.y;
+			m_origins[granule * 4 + 2] = origin.z;
+		}
+
+		glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+		glBufferSubData(GL_TEXTURE_BUFFER,
+		                sizeof(std::int32_t) * 4 * offset,
+		                sizeof(std::int32_t) * 4 * granules,
+		                m_origins.data() + offset * 4);
 	}
-	else
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_arenaBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(ChunkVertex) * data.first,
+	                sizeof(ChunkVertex) * mesh.size(), mesh.data());
+
+	m_vertexCount    = m_vertexCount - data.vertexCount + mesh.size();
+	data.vertexCount = mesh.size();
+}
+
+void ChunkRenderer::release(ChunkRenderData& data)
+{
+	if (data.capacity != 0)
 	{
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.size(), mesh.data(),
-		             GL_DYNAMIC_DRAW);
-		it->second.vertexCount = mesh.size();
+		m_arena.free(data.first / ARENA_GRANULE,
+		             data.capacity / ARENA_GRANULE);
+		m_vertexCount -= data.vertexCount;
 	}
+
+	data = {};
 }
 
-void ChunkRenderer::dropChunk(math::vec3 pos) { m_buffers.erase(pos); }
+std::size_t ChunkRenderer::allocate(std::size_t granules)
+{
+	const std::size_t offset = m_arena.allocate(granules);
+	if (offset != ArenaAllocator::INVALID)
+	{
+		return offset;
+	}
 
-void ChunkRenderer::render()
+	// there's no gap large enough. If packing everything together would
+	// leave the arena at most 3/4 full that's enough, otherwise grow it
+	// while everything's being moved anyway.
+	const std::size_t needed   = m_arena.getUsed() + granules;
+	std::size_t       capacity = m_arena.getCapacity();
+	while (needed * 4 > capacity * 3)
+	{
+		capacity *= 2;
+	}
+
+	compact(capacity);
+
+	return m_arena.allocate(granules);
+}
+
+void ChunkRenderer::compact(std::size_t granules)
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+	struct Section
+	{
+		ChunkRenderData* data;
+		voxels::BlockPos origin;
+	};
+
+	// pack the sections in the order they're already in, so what was
+	// allocated together stays together.
+	std::vector<Section> sections;
+	m_buffers.forEach(
+	    [&sections](const voxels::ChunkPos& pos, SectionRenderData& chunk) {
+		    const voxels::BlockPos origin = voxels::toBlockPos(pos);
+		    for (ChunkRenderData& data : chunk)
+		    {
+			    if (data.capacity != 0)
+			    {
+				    sections.push_back({&data, origin});
+			    }
+		    }
+	    });
+
+	std::sort(sections.begin(), sections.end(),
+	          [](const Section& lhs, const Section& rhs) {
+		          return lhs.data->first < rhs.data->first;
+	          });
+
+	unsigned int buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER,
+	             sizeof(ChunkVertex) * ARENA_GRANULE * granules, nullptr,
+	             GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, m_arenaBuffer);
+
+	m_origins.assign(granules * 4, 0);
 
-	for (auto& buffer : m_buffers)
+	std::size_t next  = 0;
+	std::size_t moved = 0;
+	for (const Section& section : sections)
 	{
-		glBindVertexArray(buffer.second.vao);
-		glDrawArrays(GL_TRIANGLES, 0, buffer.second.vertexCount);
+		ChunkRenderData& data = *section.data;
+
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		                    sizeof(ChunkVertex) * data.first,
+		                    sizeof(ChunkVertex) * next * ARENA_GRANULE,
+		                    sizeof(ChunkVertex) * data.vertexCount);
+		moved += sizeof(ChunkVertex) * data.vertexCount;
+
+		const std::size_t reserved = data.capacity / ARENA_GRANULE;
+		for (std::size_t granule = next; granule < next + reserved;
+		     ++granule)
+		{
+			m_origins[granule * 4]     = section.origin.x;
+			m_origins[granule * 4 + 1] = section.origin.y;
+			m_origins[granule * 4 + 2] = section.origin.z;
+		}
+
+		data.first = next * ARENA_GRANULE;
+		next += reserved;
 	}
+
+	glDeleteBuffers(1, &m_arenaBuffer);
+	m_arenaBuffer = buffer;
+	m_arena.reset(granules, next);
+
+	++m_stats.compactions;
+	m_stats.compactedBytes = moved;
+
+	bindArena();
 }
 
+void ChunkRenderer::bindArena()
+{
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_arenaBuffer);
+
+	// both attributes are bit packed, so they must stay integers all the
+	// way into the shader.
+	glVertexAttribIPointer(
+	    m_dataAttributeLocation, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex),
+	    reinterpret_cast<void*>(offsetof(ChunkVertex, data)));
+
+	glVertexAttribIPointer(
+	    m_colorAttributeLocation, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex),
+	    reinterpret_cast<void*>(offsetof(ChunkVertex, color)));
+
+	glEnableVertexAttribArray(m_dataAttributeLocation);
+	glEnableVertexAttribArray(m_colorAttributeLocation);
+
+	// the index buffer binding is part of the vertex array's state.
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadIndices);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(std::int32_t) * m_origins.size(),
+	             m_origins.data(), GL_DYNAMIC_DRAW);
+
+	glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32I, m_originBuffer);
+}
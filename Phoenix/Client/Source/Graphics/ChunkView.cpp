@@ -27,17 +27,29 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <Client/Graphics/ChunkView.hpp>
-#include <Client/Graphics/ChunkMesher.hpp>
 
+#include <Common/Settings.hpp>
 #include <Common/Voxels/BlockRegistry.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <thread>
 #include <utility>
+#include <vector>
 
 using namespace phx::voxels;
 using namespace phx;
 
+// normalizes a direction, leaving a zero direction alone rather than
+// dividing by zero.
+static math::vec3 normalizeOrZero(const math::vec3& direction)
+{
+	const float lengthSq = math::vec3::dotProduct(direction, direction);
+	return lengthSq > 0.f ? direction / std::sqrt(lengthSq) : direction;
+}
+
 ChunkView::ChunkView(int viewDistance, Map&& map)
-    : m_viewDistance(viewDistance), m_map(std::move(map))
+    : m_activeChunks(viewDistance), m_map(std::move(map))
 {
 	// calculates the maximum visible chunks.
 	const int viewLength       = (viewDistance * 2) + 1;
@@ -45,171 +57,323 @@ ChunkView::ChunkView(int viewDistance, Map&& map)
 
 	m_renderer = new gfx::ChunkRenderer(maxVisibleChunks);
 	m_renderer->buildTextureArray();
+
+	// the cores left by the main thread and the map's generation threads,
+	// so the two pools don't fight over the same cores.
+	const std::size_t cores = std::thread::hardware_concurrency();
+	const std::size_t busy  = 1 + m_map.getGenerationThreadCount();
+	m_meshPool = new gfx::ChunkMeshPool(cores > busy ? cores - busy : 1,
+	                                    m_renderer->getBlockLayers());
+
+	m_greedyMeshing =
+	    Settings::get()->add("Greedy Meshing", "graphics:greedyMeshing", 1);
+	m_greedyMeshing->setMin(0);
+	m_greedyMeshing->setMax(1);
+
+	// in KiB, roughly 4 - 8 chunks' worth of greedy meshes.
+	m_uploadBudget = Settings::get()->add("Mesh Upload Budget",
+	                                      "graphics:meshUploadBudget", 1024);
+	m_uploadBudget->setMin(64);
+	m_uploadBudget->setMax(65536);
+
+	// in chunks, past the distance they stop being needed at.
+	m_unloadMargin = Settings::get()->add("Chunk Unload Margin",
+	                                      "graphics:unloadMargin", 2);
+	m_unloadMargin->setMin(1);
+	m_unloadMargin->setMax(8);
+
+	// how far down the load queue chunks are requested from the map,
+	// each submission copies a chunk too so that's kept to a handful.
+	m_loadBudget = Settings::get()->add("Chunk Load Budget",
+	                                    "graphics:chunkLoadBudget", 32);
+	m_loadBudget->setMin(1);
+	m_loadBudget->setMax(4096);
+
+	m_meshBudget = Settings::get()->add("Mesh Submit Budget",
+	                                    "graphics:meshSubmitBudget", 16);
+	m_meshBudget->setMin(1);
+	m_meshBudget->setMax(4096);
 }
 
-ChunkView::~ChunkView() { delete m_renderer; }
+ChunkView::~ChunkView()
+{
+	// the workers use the renderer's layer table, so they have to stop
+	// first.
+	delete m_meshPool;
+	delete m_renderer;
+}
 
-void ChunkView::tick(math::vec3 playerPos)
+void ChunkView::tick(math::vec3 playerPos, const math::vec3& viewDirection)
 {
 	// this block converts the raw camera/player position into voxel-world
 	// positions.
 	playerPos = playerPos / 2.f;
 	playerPos += 0.5f;
 
-	const int posX = static_cast<int>(playerPos.x) / Chunk::CHUNK_WIDTH;
-	const int posY = static_cast<int>(playerPos.y) / Chunk::CHUNK_HEIGHT;
-	const int posZ = static_cast<int>(playerPos.z) / Chunk::CHUNK_DEPTH;
+	const ChunkPos center = toChunkPos(toBlockPos(playerPos));
+
+	// chunks are only meshed once all six of their neighbours are loaded,
+	// so faces hidden by a neighbour can be culled. The outermost visible
+	// chunks have neighbours one chunk past the view distance.
+	const int loadDistance = m_activeChunks.getViewDistance() + 1;
+	const int margin       = m_unloadMargin->value();
 
-	// Get diameter to generate for.
-	const int chunkViewDistance = m_viewDistance;
+	// chunks still waiting for their mesh when they leave view have it
+	// cancelled, meshed chunks stay in the renderer until they're past the
+	// margin.
+	const auto cancel = [this](const ChunkPos& pos) {
+		return m_meshPool->cancel(pos);
+	};
 
-	for (int x = -chunkViewDistance; x <= chunkViewDistance; x++)
+	for (const ChunkPos& pos : m_activeChunks.drop(center, margin, cancel))
 	{
-		for (int y = -chunkViewDistance; y <= chunkViewDistance; y++)
-		{
-			for (int z = -chunkViewDistance; z <= chunkViewDistance; z++)
-			{
-				math::vec3 chunkToCheck = {static_cast<float>(x + posX),
-				                           static_cast<float>(y + posY),
-				                           static_cast<float>(z + posZ)};
+		m_renderer->dropChunk(pos);
+	}
 
-				chunkToCheck =
-				    chunkToCheck * static_cast<float>(Chunk::CHUNK_WIDTH);
+	// the map only needs sweeping when the player crosses into another
+	// chunk. Nothing active is ever this far out, so no active chunk is
+	// left pointing at an unloaded one.
+	const bool moved = !m_hasLastCenter || !(center == m_lastCenter);
+	if (moved)
+	{
+		m_stats.unloadedChunks +=
+		    m_map.unloadChunks([&center, loadDistance, margin](
+		                           const ChunkPos& pos) {
+			    return !ActiveChunks::isWithin(pos, center,
+			                                   loadDistance + margin);
+		    });
+
+		m_lastCenter    = center;
+		m_hasLastCenter = true;
+	}
 
-				auto result =
-				    std::find_if(m_activeChunks.begin(), m_activeChunks.end(),
-				                 [chunkToCheck](const Chunk& o) -> bool {
-					                 return o.getChunkPos() == chunkToCheck;
-				                 });
+	// turning far enough changes which chunks are in front of the camera,
+	// roughly half of a 90 degree field of view.
+	static constexpr float TURN_COSINE = 0.7f;
 
-				if (result == m_activeChunks.end())
-				{
-					m_activeChunks.emplace_back(m_map.getChunk(chunkToCheck));
+	const math::vec3 direction = normalizeOrZero(viewDirection);
+	const bool       turned =
+	    math::vec3::dotProduct(direction, direction) > 0.f &&
+	    math::vec3::dotProduct(direction, m_activeChunks.getQueueDirection()) <
+	        TURN_COSINE;
 
-					gfx::ChunkMesher mesher(chunkToCheck,
-					                        m_activeChunks.back().getBlocks(),
-					                        m_renderer->getTextureTable());
+	if (moved || turned)
+	{
+		m_activeChunks.rebuildLoadQueue(center, direction);
+	}
 
-					mesher.mesh();
+	processLoadQueue();
 
-					m_renderer->submitChunk(mesher.getMesh(), chunkToCheck);
-				}
-			}
+	// upload finished meshes until this frame's budget is spent, whatever
+	// is left waits for the next frame. At least one is always uploaded
+	// so a huge mesh can't get stuck.
+	const std::size_t budget =
+	    static_cast<std::size_t>(m_uploadBudget->value()) * 1024;
+	std::size_t uploaded = 0;
+
+	gfx::ChunkMeshResult result;
+	while (uploaded < budget && m_meshPool->pop(result))
+	{
+		for (int section = 0; section < gfx::CHUNK_SECTION_COUNT; ++section)
+		{
+			if ((result.sections & (1u << section)) == 0)
+				continue;
+
+			const std::vector<gfx::ChunkVertex>& mesh = result.meshes[section];
+			m_renderer->updateChunk(mesh, result.pos, section);
+			uploaded += mesh.size() * sizeof(gfx::ChunkVertex);
 		}
 	}
+
+	// writes any edited chunks out in the background every so often.
+	m_map.tick();
+
+	m_stats.loadedChunks     = m_map.getChunkCount();
+	m_stats.loadedBytes      = m_map.getMemoryUsage();
+	m_stats.activeChunks     = m_activeChunks.size();
+	m_stats.queuedChunks     = m_activeChunks.getLoadQueue().size();
+	m_stats.generatingChunks = m_map.getPendingChunkCount();
+}
+
+void ChunkView::render(const math::mat4& viewProjection)
+{
+	m_renderer->render(viewProjection);
+	m_stats.render = m_renderer->getStats();
 }
 
-void ChunkView::render() { m_renderer->render(); }
+const ChunkViewStats& ChunkView::getStats() const { return m_stats; }
 
-BlockType* ChunkView::getBlockAt(math::vec3 position) const
+BlockType* ChunkView::getBlockAt(const BlockPos& position) const
 {
-	int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
-	int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
-	int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+	return BlockRegistry::get()->getFromRegistryID(
+	    m_activeChunks.getBlockIDAt(position));
+}
 
-	position.x =
-	    static_cast<float>(static_cast<int>(position.x) % Chunk::CHUNK_WIDTH);
-	if (position.x < 0)
-	{
-		posX -= 1;
-		position.x += Chunk::CHUNK_WIDTH;
-	}
+std::size_t ChunkView::getBlockIDAt(const BlockPos& position) const
+{
+	return m_activeChunks.getBlockIDAt(position);
+}
 
-	position.y =
-	    static_cast<float>(static_cast<int>(position.y) % Chunk::CHUNK_HEIGHT);
-	if (position.y < 0)
-	{
-		posY -= 1;
-		position.y += Chunk::CHUNK_HEIGHT;
-	}
+void ChunkView::setBlockAt(const BlockPos& position, BlockType* block)
+{
+	// the map owns the one and only copy of the chunk, so there's nothing
+	// to keep in sync here - just remesh if it's visible. The mesher works
+	// on a snapshot, so the new mesh shows up a frame or so later.
+	m_map.setBlockAt(position, block);
+
+	ActiveChunks::forEachEdited(
+	    position, [this](const ChunkPos& chunkPos, gfx::SectionMask sections) {
+		    remesh(chunkPos, sections);
+	    });
+}
 
-	position.z =
-	    static_cast<float>(static_cast<int>(position.z) % Chunk::CHUNK_DEPTH);
-	if (position.z < 0)
+bool ChunkView::fill(const BlockPos& min, const BlockPos& max,
+                     BlockType* block)
+{
+	if (!m_map.fill(min, max, block))
 	{
-		posZ -= 1;
-		position.z += Chunk::CHUNK_DEPTH;
+		return false;
 	}
 
-	const math::vec3 chunkPosition =
-	    math::vec3(static_cast<float>(posX * Chunk::CHUNK_WIDTH),
-	               static_cast<float>(posY * Chunk::CHUNK_HEIGHT),
-	               static_cast<float>(posZ * Chunk::CHUNK_DEPTH));
+	BlockPos low  = min;
+	BlockPos high = max;
+	sortCorners(low, high);
+	remeshRegion(low, high);
 
-	for (auto& chunk : m_activeChunks)
+	return true;
+}
+
+std::optional<BlockRegion> ChunkView::read(const BlockPos& min,
+                                           const BlockPos& max)
+{
+	return m_map.read(min, max);
+}
+
+bool ChunkView::write(const BlockRegion& region, const BlockPos& origin)
+{
+	if (!m_map.write(region, origin))
 	{
-		if (chunk.getChunkPos() == chunkPosition)
-		{
-			return chunk.getBlockAt({
-			    // "INLINE" VECTOR 3 DECLARATION
-			    position.x, // x position IN the chunk, not overall
-			    position.y, // y position IN the chunk, not overall
-			    position.z  // z position IN the chunk, not overall
-			});
-		}
+		return false;
 	}
 
-	return BlockRegistry::get()->getFromRegistryID(
-	    BlockRegistry::OUT_OF_BOUNDS_BLOCK);
+	remeshRegion(origin, origin + region.getSize() - 1);
+	return true;
 }
 
-void ChunkView::setBlockAt(math::vec3 position, BlockType* block)
+void ChunkView::remeshRegion(const BlockPos& min, const BlockPos& max)
 {
-	m_map.setBlockAt(position, block);
+	// one block further out on every side, blocks on the edge of a chunk
+	// or section change the faces of the one next to them.
+	const BlockPos low  = min - 1;
+	const BlockPos high = max + 1;
 
-	int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
-	int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
-	int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+	const ChunkPos first = toChunkPos(low);
+	const ChunkPos last  = toChunkPos(high);
 
-	position.x =
-	    static_cast<float>(static_cast<int>(position.x) % Chunk::CHUNK_WIDTH);
-	if (position.x < 0)
-	{
-		posX -= 1;
-		position.x += Chunk::CHUNK_WIDTH;
-	}
+	const int height = gfx::CHUNK_SECTION_HEIGHT;
 
-	position.y =
-	    static_cast<float>(static_cast<int>(position.y) % Chunk::CHUNK_HEIGHT);
-	if (position.y < 0)
+	for (int y = first.y; y <= last.y; ++y)
 	{
-		posY -= 1;
-		position.y += Chunk::CHUNK_HEIGHT;
+		// the sections of this layer of chunks the box reaches.
+		const int bottom  = y * Chunk::CHUNK_HEIGHT;
+		const int lowest  = std::max(low.y - bottom, 0) / height;
+		const int highest =
+		    std::min(high.y - bottom, Chunk::CHUNK_HEIGHT - 1) / height;
+
+		gfx::SectionMask sections = 0;
+		for (int section = lowest; section <= highest; ++section)
+		{
+			sections |= 1u << section;
+		}
+
+		for (int z = first.z; z <= last.z; ++z)
+		{
+			for (int x = first.x; x <= last.x; ++x)
+			{
+				remesh(ChunkPos(x, y, z), sections);
+			}
+		}
 	}
+}
 
-	position.z =
-	    static_cast<float>(static_cast<int>(position.z) % Chunk::CHUNK_DEPTH);
-	if (position.z < 0)
+void ChunkView::remesh(const ChunkPos& chunkPos, gfx::SectionMask sections)
+{
+	if (m_activeChunks.contains(chunkPos))
 	{
-		posZ -= 1;
-		position.z += Chunk::CHUNK_DEPTH;
+		// edits jump the queue, and replace any mesh still in progress.
+		m_meshPool->submit(m_map.getSnapshot(chunkPos),
+		                   getNeighbours(chunkPos), getMeshingMode(), sections,
+		                   true);
 	}
+}
 
-	const math::vec3 chunkPosition =
-	    math::vec3(static_cast<float>(posX * Chunk::CHUNK_WIDTH),
-	               static_cast<float>(posY * Chunk::CHUNK_HEIGHT),
-	               static_cast<float>(posZ * Chunk::CHUNK_DEPTH));
-
-	for (auto& chunk : m_activeChunks)
+void ChunkView::processLoadQueue()
+{
+	const std::size_t loadBudget = m_loadBudget->value();
+	const std::size_t meshBudget = m_meshBudget->value();
+
+	// only the front of the queue is requested, so the map's workers are
+	// never far behind when the queue is rebuilt. The rest is requested
+	// as the front is meshed.
+	std::vector<ChunkPos>& queue = m_activeChunks.getLoadQueue();
+
+	const std::size_t window = std::min(loadBudget, queue.size());
+	const std::size_t last   = queue.size() - window;
+
+	// requesting what's already requested is cheap, the map only loads
+	// each chunk once.
+	const auto isResident = [this](const ChunkPos& pos) {
+		if (m_map.findChunk(pos) != nullptr)
+			return true;
+
+		m_map.requestChunk(pos);
+		return false;
+	};
+
+	std::size_t submitted = 0;
+	std::size_t i         = queue.size();
+	while (i > last && submitted < meshBudget)
 	{
-		if (chunk.getChunkPos() == chunkPosition)
+		const ChunkPos pos = queue[--i];
+
+		// the neighbours are needed too, to cull the faces on the chunk's
+		// edges.
+		bool ready = isResident(pos);
+		for (const ChunkPos& offset : ActiveChunks::NEIGHBOURS)
 		{
-			chunk.setBlockAt(
-			    {
-			        // "INLINE" VECTOR 3 DECLARATION
-			        position.x, // x position IN the chunk, not overall
-			        position.y, // y position IN the chunk, not overall
-			        position.z  // z position IN the chunk, not overall
-			    },
-			    block);
-
-			gfx::ChunkMesher mesher(chunkPosition, chunk.getBlocks(),
-			                        m_renderer->getTextureTable());
-			mesher.mesh();
-
-			m_renderer->updateChunk(mesher.getMesh(), chunkPosition);
-
-			break;
+			ready = isResident(pos + offset) && ready;
 		}
+
+		// tried again next frame, the map adds loaded chunks in tick().
+		if (!ready)
+			continue;
+
+		queue.erase(queue.begin() + i);
+
+		m_activeChunks.add(pos, m_map.findChunk(pos));
+		m_meshPool->submit(m_map.getSnapshot(pos), getNeighbours(pos),
+		                   getMeshingMode());
+		++submitted;
 	}
 }
+
+gfx::ChunkMeshPool::Neighbours ChunkView::getNeighbours(
+    const ChunkPos& chunkPos) const
+{
+	// neighbours come from the map rather than the active chunks, since
+	// they only need to be loaded - not visible.
+	gfx::ChunkMeshPool::Neighbours neighbours;
+	for (std::size_t face = 0; face < neighbours.size(); ++face)
+	{
+		neighbours[face] =
+		    m_map.getSnapshot(chunkPos + ActiveChunks::NEIGHBOURS[face]);
+	}
+
+	return neighbours;
+}
+
+gfx::MeshingMode ChunkView::getMeshingMode() const
+{
+	return m_greedyMeshing->value() != 0 ? gfx::MeshingMode::GREEDY
+	                                     : gfx::MeshingMode::NAIVE;
+}
@@ -94,11 +94,13 @@ math::Ray Player::getTarget() const
 
 	math::Ray ray(pos, rotToDir(m_registry->get<Position>(m_entity).rotation));
 
+	const voxels::BlockProperties& properties =
+	    voxels::BlockRegistry::get()->getProperties();
+
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
-
-		if (m_world->getBlockAt(pos)->category == voxels::BlockCategory::SOLID)
+		if (properties.isCollidable(
+		        m_world->getBlockIDAt(voxels::toBlockPos(pos))))
 		{
 			return ray;
 		}
@@ -115,19 +117,25 @@ bool Player::action1()
 
 	math::Ray ray(pos, rotToDir(m_registry->get<Position>(m_entity).rotation));
 
+	const voxels::BlockProperties& properties =
+	    voxels::BlockRegistry::get()->getProperties();
+
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
+		const voxels::BlockPos blockPos = voxels::toBlockPos(pos);
 
-		const auto currentBlock = m_world->getBlockAt(pos);
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		const std::size_t id = m_world->getBlockIDAt(blockPos);
+		if (properties.isCollidable(id))
 		{
+			const auto currentBlock =
+			    voxels::BlockRegistry::get()->getFromRegistryID(id);
+
 			m_world->setBlockAt(
-			    pos, voxels::BlockRegistry::get()->getFromID("core.air"));
+			    blockPos, voxels::BlockRegistry::get()->getFromID("core.air"));
 
 			if (currentBlock->onBreak)
 			{
-				currentBlock->onBreak(pos.x, pos.y, pos.z);
+				currentBlock->onBreak(blockPos.x, blockPos.y, blockPos.z);
 			}
 
 			return true;
@@ -145,15 +153,16 @@ bool Player::action2()
 
 	math::Ray ray(pos, rotToDir(m_registry->get<Position>(m_entity).rotation));
 
+	const voxels::BlockProperties& properties =
+	    voxels::BlockRegistry::get()->getProperties();
+
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
-
-		const auto currentBlock = m_world->getBlockAt(pos);
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		if (properties.isCollidable(
+		        m_world->getBlockIDAt(voxels::toBlockPos(pos))))
 		{
-			math::vec3 back = ray.backtrace(RAY_INCREMENT);
-			back.floor();
+			const voxels::BlockPos back =
+			    voxels::toBlockPos(ray.backtrace(RAY_INCREMENT));
 
 			m_world->setBlockAt(back, m_registry->get<Hand>(getEntity()).hand);
 
@@ -181,16 +190,18 @@ math::vec3 Player::rotToDir(math::vec3 m_rotation)
 
 void Player::renderSelectionBox(const math::mat4 view, const math::mat4 proj)
 {
-	auto pos = getTarget().getCurrentPosition();
-	pos.floor();
+	const voxels::BlockPos target =
+	    voxels::toBlockPos(getTarget().getCurrentPosition());
 	// do not waste cpu time if we aren't targetting a solid block
-	if (m_world->getBlockAt(pos)->category != voxels::BlockCategory::SOLID)
+	if (!voxels::BlockRegistry::get()->getProperties().isCollidable(
+	        m_world->getBlockIDAt(target)))
 		return;
 
 	// voxel position to camera position
-	pos.x = (pos.x - 0.5f) * 2.f;
-	pos.y = (pos.y - 0.5f) * 2.f;
-	pos.z = (pos.z - 0.5f) * 2.f;
+	math::vec3 pos;
+	pos.x = (static_cast<float>(target.x) - 0.5f) * 2.f;
+	pos.y = (static_cast<float>(target.y) - 0.5f) * 2.f;
+	pos.z = (static_cast<float>(target.z) - 0.5f) * 2.f;
 
 	/*
 	       1 +--------+ 2
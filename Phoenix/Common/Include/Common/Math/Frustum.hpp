@@ -0,0 +1,139 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Math/Matrix4x4.hpp>
+#include <Common/Math/Vector3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::math
+{
+	/**
+	 * @brief A list of axis aligned bounding boxes, stored a component at a
+	 * time so whole batches of them can be tested at once.
+	 */
+	struct AABBList
+	{
+		using vec3 = detail::Vector3<float>;
+
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+
+		/**
+		 * @brief Adds a box to the end of the list.
+		 * @param min The lowest corner of the box.
+		 * @param max The highest corner of the box.
+		 */
+		void push(const vec3& min, const vec3& max);
+
+		/**
+		 * @brief Removes every box, keeping the memory for the next batch.
+		 */
+		void clear();
+
+		/**
+		 * @brief Gets the number of boxes in the list.
+		 * @return The number of boxes in the list.
+		 */
+		std::size_t size() const { return minX.size(); }
+	};
+
+	/**
+	 * @brief The six planes bounding what a view-projection matrix can see,
+	 * for throwing away things that can't be on screen before drawing them.
+	 *
+	 * The test is conservative: a box is only rejected if it is entirely
+	 * behind one of the planes, so some boxes just outside the corners of
+	 * the frustum are kept.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Frustum frustum(camera->getProjection() *
+	 *                 camera->calculateViewMatrix());
+	 *
+	 * AABBList boxes;
+	 * boxes.push({0.f, 0.f, 0.f}, {32.f, 32.f, 32.f});
+	 *
+	 * std::vector<std::uint8_t> visible;
+	 * frustum.intersects(boxes, visible);
+	 * @endcode
+	 */
+	class Frustum
+	{
+		using vec3 = detail::Vector3<float>;
+
+	public:
+		/**
+		 * @brief Constructs a frustum that contains everything.
+		 */
+		Frustum();
+
+		/**
+		 * @brief Constructs the frustum of a view-projection matrix.
+		 * @param viewProjection The projection matrix multiplied by the
+		 * view matrix, as given to the shader.
+		 */
+		explicit Frustum(const detail::Matrix4x4& viewProjection);
+
+		/**
+		 * @brief Tests whether a single box is at least partly inside the
+		 * frustum.
+		 * @param min The lowest corner of the box.
+		 * @param max The highest corner of the box.
+		 * @return Whether the box could be visible.
+		 */
+		bool intersects(const vec3& min, const vec3& max) const;
+
+		/**
+		 * @brief Tests a whole list of boxes against the frustum.
+		 * @param boxes The boxes to test.
+		 * @param visible Resized to the number of boxes and set to 1 for
+		 * every box that could be visible, 0 for the rest.
+		 * @return The number of boxes that could be visible.
+		 *
+		 * Boxes are tested four at a time with SSE where it's available,
+		 * this is intended for culling thousands of chunks or entities
+		 * every frame.
+		 */
+		std::size_t intersects(const AABBList&            boxes,
+		                       std::vector<std::uint8_t>& visible) const;
+
+	private:
+		// a, b, c and d of each plane, as in ax + by + cz + d = 0, with the
+		// normal (a, b, c) pointing into the frustum.
+		float m_planes[6][4];
+	};
+} // namespace phx::math
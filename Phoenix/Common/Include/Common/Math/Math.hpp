@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <Common/Math/Frustum.hpp>
 #include <Common/Math/MathUtils.hpp>
 #include <Common/Math/Matrix4x4.hpp>
 #include <Common/Math/Vector2.hpp>
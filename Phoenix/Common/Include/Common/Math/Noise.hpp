@@ -0,0 +1,126 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace phx::math
+{
+	/**
+	 * @brief Seeded gradient noise, for generating terrain.
+	 *
+	 * This is Perlin's gradient noise, except the gradient at each lattice
+	 * point comes from hashing the point with the seed rather than from a
+	 * shuffled permutation table. Any seed works, nothing has to be built
+	 * up front, and the same seed gives the same noise on every platform.
+	 * Values are roughly within [-1, 1], and exactly 0 on every lattice
+	 * point.
+	 *
+	 * Sampling points one at a time is fine for the odd lookup, but
+	 * terrain wants whole grids of them - fill2D() and fill3D() evaluate
+	 * four points at once with SSE2 where it's available. Both paths do
+	 * exactly the same floating point operations, so they give identical
+	 * results and worlds don't change between builds.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Noise noise(seed);
+	 *
+	 * // 16 x 16 heights, one every block.
+	 * float heights[16 * 16];
+	 * noise.fill2D(heights, chunkX * 16.f, chunkZ * 16.f, 16, 16, 1 / 64.f);
+	 * @endcode
+	 */
+	class Noise
+	{
+	public:
+		/**
+		 * @brief Constructs the noise for a seed.
+		 * @param seed The seed, the same seed always gives the same noise.
+		 */
+		explicit Noise(std::uint32_t seed);
+
+		/**
+		 * @brief Samples the noise at a 2D position.
+		 * @param x The x position, in lattice cells.
+		 * @param y The y position, in lattice cells.
+		 * @return The noise at the position, roughly within [-1, 1].
+		 */
+		float at(float x, float y) const;
+
+		/**
+		 * @brief Samples the noise at a 3D position.
+		 * @param x The x position, in lattice cells.
+		 * @param y The y position, in lattice cells.
+		 * @param z The z position, in lattice cells.
+		 * @return The noise at the position, roughly within [-1, 1].
+		 */
+		float at(float x, float y, float z) const;
+
+		/**
+		 * @brief Samples a 2D grid of points, one unit apart.
+		 * @param out Where to store the samples, width * height of them
+		 * with x varying fastest.
+		 * @param x The x position of the first point.
+		 * @param y The y position of the first point.
+		 * @param width The amount of points along x.
+		 * @param height The amount of points along y.
+		 * @param frequency What each position is multiplied by before
+		 * sampling, the inverse of the size of a lattice cell.
+		 */
+		void fill2D(float* out, float x, float y, int width, int height,
+		            float frequency) const;
+
+		/**
+		 * @brief Samples a 3D grid of points, one unit apart.
+		 * @param out Where to store the samples, width * height * depth of
+		 * them with x varying fastest then y - the same order as the blocks
+		 * of a chunk.
+		 * @param x The x position of the first point.
+		 * @param y The y position of the first point.
+		 * @param z The z position of the first point.
+		 * @param width The amount of points along x.
+		 * @param height The amount of points along y.
+		 * @param depth The amount of points along z.
+		 * @param frequency What each position is multiplied by before
+		 * sampling, the inverse of the size of a lattice cell.
+		 */
+		void fill3D(float* out, float x, float y, float z, int width,
+		            int height, int depth, float frequency) const;
+
+		/**
+		 * @brief Gets the seed the noise was constructed with.
+		 * @return The seed of the noise.
+		 */
+		std::uint32_t getSeed() const { return m_seed; }
+
+	private:
+		std::uint32_t m_seed;
+	};
+} // namespace phx::math
@@ -0,0 +1,204 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file BinaryIO.hpp
+ * @brief Cursor based reading and writing of binary data.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Serialization/Endian.hpp>
+#include <Common/Serialization/SharedTypes.hpp>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace phx::data
+{
+	/**
+	 * @brief Appends values to a buffer in network byte order.
+	 *
+	 * Unlike the Serializer, this is meant for large blobs of data that are
+	 * written to disk, such as chunks. Values are appended to the end of the
+	 * buffer so writing is amortized constant time.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BinaryWriter writer;
+	 * writer.write<std::uint32_t>(4096);
+	 * writer.writeString("core.air");
+	 *
+	 * const Data& data = writer.getBuffer();
+	 * @endcode
+	 */
+	class BinaryWriter
+	{
+	public:
+		/**
+		 * @brief Appends an integer to the buffer.
+		 * @tparam T The type of integer being written.
+		 * @param value The value to write.
+		 */
+		template <typename T>
+		void write(T value)
+		{
+			static_assert(std::is_integral_v<T>,
+			              "Only integers can be written.");
+
+			value = endian::swapForNetwork(value);
+
+			const std::size_t end = m_buffer.size();
+			m_buffer.resize(end + sizeof(T));
+			std::memcpy(m_buffer.data() + end, &value, sizeof(T));
+		}
+
+		/**
+		 * @brief Appends a string to the buffer, prefixed by its length.
+		 * @param value The string to write, at most 65535 characters long.
+		 */
+		void writeString(const std::string& value)
+		{
+			write(static_cast<std::uint16_t>(value.size()));
+
+			const std::size_t end = m_buffer.size();
+			m_buffer.resize(end + value.size());
+			std::memcpy(m_buffer.data() + end, value.data(), value.size());
+		}
+
+		/**
+		 * @brief Reserves space for a rough amount of bytes.
+		 * @param size The amount of bytes expected to be written.
+		 */
+		void reserve(std::size_t size) { m_buffer.reserve(size); }
+
+		Data&       getBuffer() { return m_buffer; }
+		const Data& getBuffer() const { return m_buffer; }
+
+	private:
+		Data m_buffer;
+	};
+
+	/**
+	 * @brief Reads values in network byte order from a buffer.
+	 *
+	 * The reader never reads past the end of the buffer, once there isn't
+	 * enough data left it fails and every following read fails too - so a
+	 * whole structure can be read then checked once.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BinaryReader reader(data);
+	 *
+	 * std::uint32_t size = 0;
+	 * std::string   id;
+	 * reader.read(size);
+	 * reader.readString(id);
+	 *
+	 * if (!reader.good())
+	 * {
+	 *     // the data was truncated.
+	 * }
+	 * @endcode
+	 */
+	class BinaryReader
+	{
+	public:
+		/**
+		 * @brief Constructs a reader over a buffer.
+		 * @param buffer The buffer to read, it must outlive the reader.
+		 */
+		explicit BinaryReader(const Data& buffer) : m_buffer(buffer) {}
+
+		/**
+		 * @brief Reads an integer from the buffer.
+		 * @tparam T The type of integer being read.
+		 * @param value Where to store the value.
+		 * @return Whether the value was read.
+		 */
+		template <typename T>
+		bool read(T& value)
+		{
+			static_assert(std::is_integral_v<T>,
+			              "Only integers can be read.");
+
+			if (!canRead(sizeof(T)))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, m_buffer.data() + m_cursor, sizeof(T));
+			value = endian::swapForHost(value);
+			m_cursor += sizeof(T);
+
+			return true;
+		}
+
+		/**
+		 * @brief Reads a length prefixed string from the buffer.
+		 * @param value Where to store the string.
+		 * @return Whether the string was read.
+		 */
+		bool readString(std::string& value)
+		{
+			std::uint16_t size = 0;
+			if (!read(size) || !canRead(size))
+			{
+				return false;
+			}
+
+			value.assign(
+			    reinterpret_cast<const char*>(m_buffer.data() + m_cursor),
+			    size);
+			m_cursor += size;
+
+			return true;
+		}
+
+		/// @brief Checks whether every read so far has succeeded.
+		bool good() const { return m_good; }
+
+		/// @brief Gets how many bytes haven't been read yet.
+		std::size_t remaining() const { return m_buffer.size() - m_cursor; }
+
+	private:
+		bool canRead(std::size_t size)
+		{
+			m_good = m_good && remaining() >= size;
+			return m_good;
+		}
+
+	private:
+		const Data& m_buffer;
+		std::size_t m_cursor = 0;
+		bool        m_good   = true;
+	};
+} // namespace phx::data
@@ -0,0 +1,141 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file BlockProperties.hpp
+ * @brief Dense per block type data for hot code paths.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Voxels/Block.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The properties of every registered block type, indexed by
+	 * registry ID.
+	 *
+	 * A BlockType is a few hundred bytes of mostly cold data (names, Lua
+	 * callbacks, texture paths), so reading the category of a block by
+	 * going through a BlockType* drags all of that through the cache. This
+	 * table stores only what hot loops like meshing and raycasting need,
+	 * with each property in its own tightly packed array.
+	 *
+	 * The table is filled by the BlockRegistry as blocks are registered
+	 * and is read only for everything else. Lookups aren't bounds checked,
+	 * so only use registry IDs that came from the registry or a chunk.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * const BlockProperties& properties =
+	 *     BlockRegistry::get()->getProperties();
+	 *
+	 * if (properties.isOpaque(chunk.getBlocks().get(index)))
+	 * {
+	 *     // cull the face.
+	 * }
+	 * @endcode
+	 */
+	class BlockProperties
+	{
+	public:
+		/// @brief Flags derived from a block's data.
+		enum Flag : std::uint8_t
+		{
+			/// @brief The block hides the faces of blocks behind it.
+			FLAG_OPAQUE = 1 << 0,
+
+			/// @brief The block stops the player and raycasts.
+			FLAG_COLLIDABLE = 1 << 1,
+		};
+
+		/// @brief The texture index of a face without a texture.
+		static constexpr std::uint16_t NO_TEXTURE = 0xFFFF;
+
+		using FaceTextures = std::array<std::uint16_t, 6>;
+
+		/// @brief Checks if a block hides the faces behind it.
+		bool isOpaque(std::size_t id) const
+		{
+			return (m_flags[id] & FLAG_OPAQUE) != 0;
+		}
+
+		/// @brief Checks if a block stops the player and raycasts.
+		bool isCollidable(std::size_t id) const
+		{
+			return (m_flags[id] & FLAG_COLLIDABLE) != 0;
+		}
+
+		/// @brief Gets the bitpacked color of a block, see BlockType::color.
+		std::uint16_t getColor(std::size_t id) const { return m_colors[id]; }
+
+		/**
+		 * @brief Gets the texture of each face of a block.
+		 * @param id The registry ID of the block.
+		 * @return The TextureRegistry index of each face, in BlockFace
+		 * order, or NO_TEXTURE for blocks that aren't drawn.
+		 */
+		const FaceTextures& getTextures(std::size_t id) const
+		{
+			return m_textures[id];
+		}
+
+		/// @brief Gets the number of block types in the table.
+		std::size_t size() const { return m_flags.size(); }
+
+	private:
+		// appends a block, the block's registry ID must be size().
+		void add(const BlockType& block, const FaceTextures& textures)
+		{
+			std::uint8_t flags = 0;
+			if (block.category == BlockCategory::SOLID)
+			{
+				flags |= FLAG_OPAQUE | FLAG_COLLIDABLE;
+			}
+
+			m_flags.push_back(flags);
+			m_colors.push_back(static_cast<std::uint16_t>(block.color));
+			m_textures.push_back(textures);
+		}
+
+		friend class BlockRegistry;
+
+	private:
+		std::vector<std::uint8_t>  m_flags;
+		std::vector<std::uint16_t> m_colors;
+		std::vector<FaceTextures>  m_textures;
+	};
+} // namespace phx::voxels
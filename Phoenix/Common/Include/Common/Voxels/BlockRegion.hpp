@@ -0,0 +1,170 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/**
+ * @file BlockRegion.hpp
+ * @brief A box of blocks copied out of (or into) the world.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The registry IDs of every block in a box, packed into one
+	 * array.
+	 *
+	 * Regions are what Map::read() and Map::write() work on, so whole
+	 * structures can be copied around without going block by block. The
+	 * blocks are laid out x fastest, then y, then z, the same as in a
+	 * chunk. IDs are kept in 16 bits, which is as many as the registry
+	 * hands out (see BlockRegistry::MAX_BLOCKS).
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * std::optional<BlockRegion> region = map.read({0, 0, 0}, {7, 7, 7});
+	 * map.write(*region, {100, 0, 0});
+	 * @endcode
+	 */
+	class BlockRegion
+	{
+	public:
+		/**
+		 * @brief Creates a region filled with a single block.
+		 * @param min One corner of the box, in blocks.
+		 * @param max The opposite corner, also inside the box.
+		 * @param fill The registry ID to fill the region with, which is
+		 * BlockRegistry::UNKNOWN_BLOCK by default.
+		 *
+		 * The corners can be given in any order, they're sorted per axis.
+		 * Both have to be inside the world (see isInWorld()), and nothing
+		 * limits how big the region is - check the box with
+		 * Map::isUsableBox() first if it comes from outside the engine.
+		 */
+		BlockRegion(BlockPos min, BlockPos max, std::size_t fill = 0)
+		{
+			sortCorners(min, max);
+
+			m_min  = min;
+			m_size = max - min + 1;
+			m_blocks.assign(getVolume(m_size),
+			                static_cast<std::uint16_t>(fill));
+		}
+
+		/// @brief Gets the lowest corner of the region, in blocks.
+		const BlockPos& getMin() const { return m_min; }
+
+		/// @brief Gets the highest corner of the region, in blocks.
+		BlockPos getMax() const { return m_min + m_size - 1; }
+
+		/// @brief Gets how many blocks the region spans on each axis.
+		const BlockPos& getSize() const { return m_size; }
+
+		/// @brief Gets how many blocks are in the region.
+		std::size_t getVolume() const { return m_blocks.size(); }
+
+		/**
+		 * @brief Gets how many blocks are in a box.
+		 * @param size How many blocks the box spans on each axis.
+		 * @return The amount of blocks, without overflowing for big boxes.
+		 */
+		static std::size_t getVolume(const BlockPos& size)
+		{
+			return static_cast<std::size_t>(size.x) *
+			       static_cast<std::size_t>(size.y) *
+			       static_cast<std::size_t>(size.z);
+		}
+
+		/**
+		 * @brief Checks whether a position is inside the region.
+		 * @param pos The position relative to the region's lowest corner.
+		 */
+		bool isInBounds(const BlockPos& pos) const
+		{
+			return static_cast<unsigned>(pos.x) <
+			           static_cast<unsigned>(m_size.x) &&
+			       static_cast<unsigned>(pos.y) <
+			           static_cast<unsigned>(m_size.y) &&
+			       static_cast<unsigned>(pos.z) <
+			           static_cast<unsigned>(m_size.z);
+		}
+
+		/**
+		 * @brief Gets the index of a block in the packed array.
+		 * @param pos The position relative to the region's lowest corner,
+		 * it has to be in bounds.
+		 */
+		std::size_t getIndex(const BlockPos& pos) const
+		{
+			return static_cast<std::size_t>(pos.x) +
+			       static_cast<std::size_t>(m_size.x) *
+			           (static_cast<std::size_t>(pos.y) +
+			            static_cast<std::size_t>(m_size.y) *
+			                static_cast<std::size_t>(pos.z));
+		}
+
+		/**
+		 * @brief Gets the registry ID of a block.
+		 * @param pos The position relative to the region's lowest corner,
+		 * it has to be in bounds.
+		 */
+		std::size_t getBlockIDAt(const BlockPos& pos) const
+		{
+			return m_blocks[getIndex(pos)];
+		}
+
+		/**
+		 * @brief Sets the registry ID of a block.
+		 * @param pos The position relative to the region's lowest corner,
+		 * it has to be in bounds.
+		 * @param id The registry ID of the block.
+		 */
+		void setBlockIDAt(const BlockPos& pos, std::size_t id)
+		{
+			m_blocks[getIndex(pos)] = static_cast<std::uint16_t>(id);
+		}
+
+		/// @brief Gets the packed registry IDs of every block.
+		const std::vector<std::uint16_t>& getData() const { return m_blocks; }
+
+		/// @copydoc getData
+		std::vector<std::uint16_t>& getData() { return m_blocks; }
+
+	private:
+		BlockPos                   m_min;
+		BlockPos                   m_size;
+		std::vector<std::uint16_t> m_blocks;
+	};
+} // namespace phx::voxels
@@ -30,9 +30,12 @@
 
 #include <Common/Singleton.hpp>
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/BlockProperties.hpp>
 #include <Common/Voxels/TextureRegistry.hpp>
 #include <Common/CMS/ModManager.hpp>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace phx::voxels
@@ -72,6 +75,9 @@ namespace phx::voxels
 		/**
 		 * @brief Registers a block in the registry.
 		 * @param blockInfo The blockType already put together.
+		 *
+		 * Blocks past MAX_BLOCKS are refused, since registry IDs have to
+		 * fit in 16 bits (see BlockRegion).
 		 */
 		void registerBlock(BlockType blockInfo);
 
@@ -83,6 +89,19 @@ namespace phx::voxels
 		 */
 		BlockType* getFromID(const std::string& id);
 
+		/**
+		 * @brief Gets the registry IDs for a list of unique IDs.
+		 * @param ids The unique IDs, such as the palette of a saved chunk.
+		 * @return The registry ID for each unique ID, in the same order.
+		 * IDs that aren't registered resolve to UNKNOWN_BLOCK.
+		 *
+		 * Saves store each distinct block once, so resolving the palette
+		 * up front means loading a chunk costs one lookup per distinct
+		 * block rather than one per voxel.
+		 */
+		std::vector<std::size_t> resolvePalette(
+		    const std::vector<std::string>& ids) const;
+
 		/**
 		 * @brief Gets a block from the registry based on its registry ID.
 		 * @note The registry ID is only used during runtime, do not try to
@@ -92,6 +111,15 @@ namespace phx::voxels
 		 */
 		BlockType* getFromRegistryID(std::size_t registryID);
 
+		/**
+		 * @brief Gets the dense property table for every registered block.
+		 * @return The properties of each block, indexed by registry ID.
+		 *
+		 * Prefer this over getFromRegistryID in anything that runs per
+		 * voxel, it avoids touching the (large) BlockType entirely.
+		 */
+		const BlockProperties& getProperties() const { return m_properties; }
+
 		/**
 		 * @brief Get the textures for the block.
 		 *
@@ -103,6 +131,9 @@ namespace phx::voxels
 		static constexpr int UNKNOWN_BLOCK       = 0;
 		static constexpr int OUT_OF_BOUNDS_BLOCK = 1;
 
+		/// @brief The most blocks that can be registered.
+		static constexpr std::size_t MAX_BLOCKS = 1 << 16;
+
 	private:
 		/**
 		 * @brief Stores the blockTypes in the registry.
@@ -116,6 +147,17 @@ namespace phx::voxels
 		 */
 		std::vector<BlockType> m_blocks;
 
+		/**
+		 * @brief Maps unique IDs to registry IDs, so lookups by unique ID
+		 * don't have to compare against every registered block.
+		 */
+		std::unordered_map<std::string, std::size_t> m_ids;
+
+		/**
+		 * @brief The hot data of every block, kept in step with m_blocks.
+		 */
+		BlockProperties m_properties;
+
 		/**
 		 * @brief Stores the unique paths to textures.
 		 *
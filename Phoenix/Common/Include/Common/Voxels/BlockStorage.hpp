@@ -0,0 +1,205 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file BlockStorage.hpp
+ * @brief Palette-compressed storage for the blocks of a chunk.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Stores a fixed amount of blocks as indices into a palette.
+	 *
+	 * Instead of storing a pointer for every single block, this stores a
+	 * small palette of the registry IDs that are actually used, and a
+	 * bit-packed array of indices into that palette. The width of each
+	 * index grows with the palette (0, 1, 2, 4, 8 then 16 bits) so a chunk
+	 * made of 2 different blocks only needs 512 bytes of indices rather
+	 * than 32 KiB of pointers.
+	 *
+	 * Widths are kept to powers of two so an index never straddles two
+	 * words, which keeps reads down to a shift and a mask.
+	 *
+	 * While every block is the same, the storage is "uniform": the palette
+	 * holds that single ID and no indices are stored at all. The first set
+	 * that introduces a different ID promotes it to packed indices, and
+	 * compact() demotes it again if it ends up uniform.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BlockStorage storage(4096, airID);
+	 * storage.set(10, dirtID);
+	 *
+	 * std::size_t id = storage.get(10); // dirtID
+	 * @endcode
+	 */
+	class BlockStorage
+	{
+	public:
+		/**
+		 * @brief Constructs storage for a fixed amount of blocks.
+		 * @param size The amount of blocks to store.
+		 * @param fill The registry ID every block starts as.
+		 */
+		BlockStorage(std::size_t size, std::size_t fill);
+
+		/**
+		 * @brief Gets the registry ID of the block at an index.
+		 * @param index The flattened index of the block.
+		 * @return The registry ID of the block.
+		 */
+		std::size_t get(std::size_t index) const
+		{
+			return m_palette[readIndex(index)];
+		}
+
+		/**
+		 * @brief Gets the palette index of the block at an index.
+		 * @param index The flattened index of the block.
+		 * @return The index into getPalette() for the block.
+		 *
+		 * This is useful for hot loops, since the palette can be resolved
+		 * into whatever is needed once, then indexed directly.
+		 */
+		std::size_t getPaletteIndex(std::size_t index) const
+		{
+			return readIndex(index);
+		}
+
+		/**
+		 * @brief Sets the registry ID of the block at an index.
+		 * @param index The flattened index of the block.
+		 * @param id The registry ID to store.
+		 *
+		 * If the ID isn't in the palette yet, it is added - widening the
+		 * indices if the palette no longer fits in the current width.
+		 */
+		void set(std::size_t index, std::size_t id);
+
+		/**
+		 * @brief Sets every block to the same registry ID.
+		 * @param id The registry ID to store.
+		 *
+		 * This also resets the palette, so it's the cheapest way of
+		 * (re)initialising the storage.
+		 */
+		void fill(std::size_t id);
+
+		/**
+		 * @brief Drops palette entries that are no longer referenced.
+		 *
+		 * This is called automatically before widening the indices, but
+		 * can be called manually before saving to keep palettes tight.
+		 */
+		void compact();
+
+		/**
+		 * @brief Checks whether every block is the same.
+		 * @return Whether the storage is only holding a single ID.
+		 */
+		bool isUniform() const { return m_bits == 0; }
+
+		/// @brief Gets the amount of blocks stored.
+		std::size_t size() const { return m_size; }
+
+		/// @brief Gets the palette of registry IDs used by the storage.
+		const std::vector<std::size_t>& getPalette() const
+		{
+			return m_palette;
+		}
+
+		/// @brief Gets how many bits are used for each index.
+		std::size_t getBitsPerIndex() const { return m_bits; }
+
+		/**
+		 * @brief Gets the packed indices backing the storage.
+		 * @return The raw words, getBitsPerIndex() bits per block.
+		 *
+		 * This is only intended for serialization, alongside the palette
+		 * and width it's enough to rebuild the storage with load().
+		 */
+		const std::vector<std::uint64_t>& getData() const { return m_data; }
+
+		/**
+		 * @brief Replaces the contents of the storage with packed data.
+		 * @param palette The registry IDs the indices refer to.
+		 * @param bits How many bits are used for each index.
+		 * @param data The packed indices, as returned by getData().
+		 * @return Whether the data was valid for the storage's size.
+		 *
+		 * If the data is invalid the storage is left untouched.
+		 */
+		bool load(std::vector<std::size_t> palette, std::size_t bits,
+		          std::vector<std::uint64_t> data);
+
+		/**
+		 * @brief Gets roughly how much heap memory the storage is using.
+		 * @return The amount of bytes used by the palette and indices.
+		 */
+		std::size_t getMemoryUsage() const;
+
+	private:
+		using Word = std::uint64_t;
+
+		static constexpr std::size_t WORD_BITS = sizeof(Word) * 8;
+
+		std::size_t readIndex(std::size_t index) const
+		{
+			const std::size_t bit = index * m_bits;
+			return static_cast<std::size_t>(
+			    (m_data[bit / WORD_BITS] >> (bit % WORD_BITS)) & m_mask);
+		}
+
+		void writeIndex(std::size_t index, std::size_t value);
+
+		// finds the palette index for an ID, adding it if required.
+		std::size_t paletteIndexOf(std::size_t id);
+
+		// repacks every index into the new width.
+		void resize(std::size_t bits);
+
+		// rewrites the packed array with the provided indices.
+		void pack(std::size_t bits, const std::vector<std::size_t>& indices);
+
+	private:
+		std::size_t              m_size;
+		std::size_t              m_bits = 0;
+		Word                     m_mask = 0;
+		std::vector<std::size_t> m_palette;
+		std::vector<Word>        m_data;
+	};
+} // namespace phx::voxels
@@ -30,9 +30,14 @@
 
 #include <Common/CoreIntrinsics.hpp>
 #include <Common/Math/Math.hpp>
+#include <Common/Serialization/SharedTypes.hpp>
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/BlockRegion.hpp>
+#include <Common/Voxels/BlockStorage.hpp>
+#include <Common/Voxels/Coordinates.hpp>
 
-#include <vector>
+#include <cstdint>
+#include <memory>
 
 namespace phx::voxels
 {
@@ -53,13 +58,19 @@ namespace phx::voxels
 	 * @brief Represents a collection of blocks in a specific area.
 	 *
 	 * This class represents a 16x16x16 area of blocks, with its own
-	 * position in the world - obviously being a multiple of 16 in all
-	 * directions.
+	 * position in the world - in chunks, so the chunk at (1, 1, 1) holds
+	 * the blocks from (16, 16, 16) up to (31, 31, 31).
+	 *
+	 * The blocks are copy-on-write, copying a chunk only shares its
+	 * storage and the first edit to either copy is what actually duplicates
+	 * it. This is what makes ChunkSnapshot cheap, copies can be handed to
+	 * other threads without locking as long as each copy is only used by
+	 * one thread at a time.
 	 *
 	 * @paragraph Usage
 	 * @code
-	 * Chunk chunk = Chunk(math::vec3(0, 0, 0));
-	 * Chunk chunk2 = Chunk(math::vec3(16, 16, 16));
+	 * Chunk chunk = Chunk(ChunkPos(0, 0, 0));
+	 * Chunk chunk2 = Chunk(ChunkPos(1, 1, 1));
 	 *
 	 * // usage with renderer
 	 * ChunkRenderer* renderer = new ChunkRenderer(2); // view distance of 3.
@@ -67,10 +78,11 @@ namespace phx::voxels
 	 * before this.
 	 *
 	 * ChunkMesher mesher(chunk.getChunkPos(), chunk,
-	 * renderer->getTextureTable()); mesher.mesh();
+	 *                    renderer->getBlockLayers());
+	 * mesher.mesh();
 	 *
-	 * renderer->submitChunk(mesher.getMesh(), chunk.getChunkPos());
-	 * //renderer->updateChunk(mesher.getMesh(), chunk.getChunkPos());
+	 * renderer->submitChunk(mesher.getMesh(0), chunk.getChunkPos(), 0);
+	 * //renderer->updateChunk(mesher.getMesh(0), chunk.getChunkPos(), 0);
 	 * //renderer->dropChunk(chunk.getChunkPos());
 	 * @endcode
 	 */
@@ -79,59 +91,166 @@ namespace phx::voxels
 	public:
 		Chunk() = delete;
 
-		explicit Chunk(const math::vec3& chunkPos);
+		explicit Chunk(const ChunkPos& chunkPos);
 		~Chunk()                  = default;
 		Chunk(const Chunk& other) = default;
 		Chunk& operator=(const Chunk& other) = default;
 		Chunk(Chunk&& other) noexcept        = default;
 		Chunk& operator=(Chunk&& other) noexcept = default;
 
-		Chunk(const math::vec3& chunkPos, const std::string& save);
+		/**
+		 * @brief Constructs a chunk from the old text save format.
+		 * @param chunkPos The position of the chunk, in chunks.
+		 * @param save Every block's ID, each followed by a ';'.
+		 *
+		 * This is only kept around to import old saves, chunks are now
+		 * saved using save() and load().
+		 */
+		Chunk(const ChunkPos& chunkPos, const std::string& save);
 
-		std::string save();
+		/**
+		 * @brief Serializes the blocks of the chunk.
+		 * @return The binary payload of the chunk.
+		 *
+		 * The payload is the palette as string IDs (so it survives the
+		 * registry IDs changing between runs, e.g. when mods are added),
+		 * followed by the packed indices:
+		 *
+		 * @code
+		 * uint16 paletteSize
+		 * struct { uint16 length; char id[length]; } palette[paletteSize]
+		 * uint8  bitsPerIndex
+		 * uint32 wordCount
+		 * uint64 words[wordCount]
+		 * @endcode
+		 *
+		 * IDs that no block uses anymore are saved too, call compact()
+		 * first to leave them out.
+		 */
+		data::Data save() const;
 
 		/**
-		 * @brief Quick function to create solid chunks of grass.
+		 * @brief Drops IDs that no block uses anymore from the palette.
 		 *
-		 * @todo Replace this with MapGen
+		 * Nothing is done while the blocks are shared with a snapshot,
+		 * they aren't worth copying just for this.
+		 */
+		void compact();
+
+		/**
+		 * @brief Replaces the blocks of the chunk with a saved payload.
+		 * @param payload A payload created by save().
+		 * @return Whether the payload was valid, the chunk is left
+		 * untouched if it wasn't.
 		 */
-		void autoTestFill();
+		bool load(const data::Data& payload);
 
 		/**
 		 * @brief Get the position of the chunk.
-		 * @return math::vec3 The position of the chunk.
+		 * @return ChunkPos The position of the chunk, in chunks.
 		 */
-		math::vec3 getChunkPos() const;
+		ChunkPos getChunkPos() const;
 
 		/**
-		 * @brief Get a vector of pointers to all the blocks in the chunk.
-		 * @return std::vector<BlockType*>& Vector of pointers to all the
-		 * blocks in the chunk.
+		 * @brief Get the palette-compressed storage of the chunk's blocks.
+		 * @return const BlockStorage& The registry IDs of every block in
+		 * the chunk.
 		 */
-		std::vector<BlockType*>& getBlocks();
+		const BlockStorage& getBlocks() const;
+
+		/**
+		 * @brief Gets the version of the chunk's blocks.
+		 * @return A number that goes up with every edit.
+		 *
+		 * Two copies of a chunk with the same version hold the same blocks.
+		 */
+		std::uint64_t getVersion() const { return m_version; }
+
+		/**
+		 * @brief Checks if every block in the chunk is the same.
+		 * @return Whether the chunk is made of a single block type.
+		 *
+		 * Uniform chunks (such as ones that are entirely air) only store a
+		 * single block ID until a different block is placed in them.
+		 */
+		bool isUniform() const { return m_blocks->isUniform(); }
 
 		/**
 		 * @brief Gets the Block at the supplied position.
 		 * @param position Position of the block relative to the chunk.
 		 * @return BlockType* The requested block.
 		 */
-		BlockType* getBlockAt(math::vec3 position) const;
+		BlockType* getBlockAt(const BlockPos& position) const;
+
+		/**
+		 * @brief Gets the registry ID of the Block at the supplied position.
+		 * @param position Position of the block relative to the chunk.
+		 * @return std::size_t The registry ID of the block, or
+		 * BlockRegistry::OUT_OF_BOUNDS_BLOCK.
+		 *
+		 * This is the cheaper option for anything that only needs the
+		 * block's properties, see BlockRegistry::getProperties().
+		 */
+		std::size_t getBlockIDAt(const BlockPos& position) const;
 
 		/**
 		 * @brief Sets the Block At the supplied position.
 		 * @param position Position of the block relative to the chunk.
 		 * @param newBlock The block that exists at this location.
 		 */
-		void setBlockAt(math::vec3 position, BlockType* newBlock);
+		void setBlockAt(const BlockPos& position, BlockType* newBlock);
+
+		/**
+		 * @brief Sets every block in a box to the same block.
+		 * @param min The lowest corner of the box, in world blocks.
+		 * @param max The highest corner of the box, inside it.
+		 * @param block The block to fill the box with.
+		 *
+		 * Only the part of the box inside the chunk is filled, and the
+		 * blocks are only copied (if shared) once for the whole box. A box
+		 * covering the whole chunk leaves it uniform.
+		 */
+		void fill(const BlockPos& min, const BlockPos& max, BlockType* block);
+
+		/**
+		 * @brief Copies the chunk's blocks into the part of a region that
+		 * overlaps the chunk.
+		 * @param region The region to copy into.
+		 */
+		void read(BlockRegion& region) const;
+
+		/**
+		 * @brief Copies the part of a region that overlaps the chunk into
+		 * the chunk.
+		 * @param region The blocks to copy.
+		 * @param origin Where the region's lowest corner is placed, in
+		 * world blocks.
+		 */
+		void write(const BlockRegion& region, const BlockPos& origin);
 
 		/// @brief How wide a chunk is (x axis).
-		static constexpr int CHUNK_WIDTH = 16;
+		static constexpr int CHUNK_WIDTH = 1 << CHUNK_WIDTH_SHIFT;
 
 		/// @brief How tall a chunk is (y axis).
-		static constexpr int CHUNK_HEIGHT = 16;
+		static constexpr int CHUNK_HEIGHT = 1 << CHUNK_HEIGHT_SHIFT;
 
 		/// @brief How deep a chunk is (z axis).
-		static constexpr int CHUNK_DEPTH = 16;
+		static constexpr int CHUNK_DEPTH = 1 << CHUNK_DEPTH_SHIFT;
+
+		/**
+		 * @brief Checks whether a position relative to a chunk is inside it.
+		 * @param pos The position relative to the chunk.
+		 * @return Whether the position is within the chunk's bounds.
+		 *
+		 * Casting to unsigned makes negative positions huge, so this only
+		 * needs a single comparison per axis.
+		 */
+		static bool isInBounds(const BlockPos& pos)
+		{
+			return static_cast<unsigned>(pos.x) < CHUNK_WIDTH &&
+			       static_cast<unsigned>(pos.y) < CHUNK_HEIGHT &&
+			       static_cast<unsigned>(pos.z) < CHUNK_DEPTH;
+		}
 
 		/**
 		 * @brief Get the Index based coordinates in a chunk.
@@ -157,17 +276,35 @@ namespace phx::voxels
 		 * @param pos The 3-dimensional position of the data.
 		 * @return The position it would be in a 1D array.
 		 */
-		ENGINE_FORCE_INLINE static std::size_t getVectorIndex(math::vec3 pos)
+		ENGINE_FORCE_INLINE static std::size_t getVectorIndex(
+		    const BlockPos& pos)
 		{
-			return getVectorIndex(static_cast<std::size_t>(pos.x),
-			                      static_cast<std::size_t>(pos.y),
-			                      static_cast<std::size_t>(pos.z));
+			return static_cast<std::size_t>(pos.x) |
+			       (static_cast<std::size_t>(pos.y) << CHUNK_WIDTH_SHIFT) |
+			       (static_cast<std::size_t>(pos.z)
+			        << (CHUNK_WIDTH_SHIFT + CHUNK_HEIGHT_SHIFT));
 		}
 
+	private:
+		// gets the blocks for writing, duplicating them first if another
+		// copy of the chunk is still sharing them.
+		BlockStorage& editBlocks();
+
 	private:
 		/// @brief The position of the chunk in relation to the map.
-		math::vec3              m_pos;
-		std::vector<BlockType*> m_blocks;
+		ChunkPos                      m_pos;
+		std::shared_ptr<BlockStorage> m_blocks;
+		std::uint64_t                 m_version = 0;
 	};
+
+	/**
+	 * @brief An immutable copy of a chunk at one version, shared between
+	 * whatever needs to read it.
+	 *
+	 * Taking a snapshot doesn't copy any blocks, and edits to the original
+	 * never show up in it, so it can be read from any thread without
+	 * locking.
+	 */
+	using ChunkSnapshot = std::shared_ptr<const Chunk>;
 } // namespace phx::voxels
 
@@ -0,0 +1,192 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/**
+ * @file ChunkScheduler.hpp
+ * @brief Loads and generates chunks on a pool of worker threads.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkStore.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Loads chunks from a ChunkStore, or generates the ones that
+	 * have never been saved, on a pool of worker threads.
+	 *
+	 * Every request for a chunk gets a future for it. Requesting a chunk
+	 * that's already queued, being worked on or finished gives back the
+	 * same future, so a chunk is never loaded twice however many things
+	 * ask for it. Requests are worked through in the order they're made.
+	 *
+	 * The chunks themselves are handed out as snapshots - whoever keeps
+	 * the chunks (such as Map) takes the finished ones with collect() and
+	 * copies them, which only shares their blocks. Once collected, a chunk
+	 * is forgotten and requesting it again loads it again.
+	 *
+	 * take() is for when a chunk is needed straight away: a request that
+	 * hasn't been started yet is run on the calling thread rather than
+	 * waiting its turn, one that has is waited on.
+	 *
+	 * A chunk whose payload can't be loaded is generated instead. If
+	 * generating it throws too, the exception is stored in its future
+	 * (and rethrown by take()), so nothing is left waiting on it.
+	 *
+	 * The store and generator are used from the workers, so they have to
+	 * outlive the scheduler.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkScheduler scheduler(3, store, generator);
+	 *
+	 * auto future = scheduler.request(ChunkPos(0, 0, 0));
+	 *
+	 * // every tick.
+	 * std::vector<ChunkSnapshot> finished;
+	 * scheduler.collect(finished);
+	 * @endcode
+	 */
+	class ChunkScheduler
+	{
+	public:
+		/// @brief A chunk that's being loaded, or has been.
+		using Result = std::shared_future<ChunkSnapshot>;
+
+		/**
+		 * @brief Starts the worker threads.
+		 * @param threads How many workers to start, at least one is.
+		 * @param store Where saved chunks are loaded from.
+		 * @param generator What generates chunks that were never saved.
+		 */
+		ChunkScheduler(std::size_t threads, ChunkStore& store,
+		               WorldGenerator& generator);
+
+		/// @brief Drops any requests that haven't started, and stops the
+		/// workers.
+		~ChunkScheduler();
+
+		ChunkScheduler(const ChunkScheduler&) = delete;
+		ChunkScheduler& operator=(const ChunkScheduler&) = delete;
+
+		/**
+		 * @brief Requests a chunk, unless it already has been.
+		 * @param pos The position of the chunk.
+		 * @return The future of the chunk.
+		 */
+		Result request(const ChunkPos& pos);
+
+		/**
+		 * @brief Gets a chunk now, and forgets about it.
+		 * @param pos The position of the chunk.
+		 * @return The chunk.
+		 *
+		 * The chunk won't be handed out by collect() after this. Whatever
+		 * generating the chunk threw is rethrown.
+		 */
+		ChunkSnapshot take(const ChunkPos& pos);
+
+		/**
+		 * @brief Takes every chunk that's finished, and forgets about them.
+		 * @param finished Where to add the chunks, in the order they
+		 * finished.
+		 * @param failed Where to add the positions of chunks that couldn't
+		 * be generated, if anywhere.
+		 * @return The amount of chunks added to finished.
+		 */
+		std::size_t collect(std::vector<ChunkSnapshot>& finished,
+		                    std::vector<ChunkPos>*      failed = nullptr);
+
+		/**
+		 * @brief Checks whether a chunk has been requested but not
+		 * collected.
+		 * @param pos The position of the chunk.
+		 * @return Whether the chunk is queued, being loaded, or finished.
+		 */
+		bool isPending(const ChunkPos& pos);
+
+		/// @brief Gets how many chunks have been requested but not
+		/// collected.
+		std::size_t getPendingCount();
+
+		/// @brief Gets how many worker threads there are.
+		std::size_t getThreadCount() const { return m_threads.size(); }
+
+	private:
+		struct Job
+		{
+			ChunkPos                    pos;
+			std::promise<ChunkSnapshot> promise;
+			Result                      result;
+
+			// set once a worker (or take()) starts on the job.
+			bool started = false;
+			// set once take() has had the chunk, so collect() skips it.
+			bool taken = false;
+		};
+
+		void run();
+
+		// loads or generates a chunk and fulfils its job.
+		void complete(const std::shared_ptr<Job>& job);
+
+		// forgets a job if it's still the one for its chunk, m_mutex must
+		// be held.
+		void forget(const std::shared_ptr<Job>& job);
+
+	private:
+		ChunkStore&     m_store;
+		WorldGenerator& m_generator;
+
+		// guards everything below.
+		std::mutex              m_mutex;
+		std::condition_variable m_wake;
+
+		// every chunk requested and not yet collected.
+		ChunkTable<std::shared_ptr<Job>>  m_jobs;
+		std::deque<std::shared_ptr<Job>>  m_queue;
+		std::vector<std::shared_ptr<Job>> m_finished;
+		bool                              m_stop = false;
+
+		std::vector<std::thread> m_threads;
+	};
+} // namespace phx::voxels
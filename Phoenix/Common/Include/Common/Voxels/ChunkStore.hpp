@@ -0,0 +1,172 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkStore.hpp
+ * @brief Loads and saves chunk payloads, writing them in the background.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Serialization/SharedTypes.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Stores chunk payloads in region files from a background thread.
+	 *
+	 * store() only queues a payload, the actual disk writes happen on an
+	 * I/O thread owned by the store. If a chunk is stored again before its
+	 * previous payload was written, only the newest one is written.
+	 *
+	 * load() sees queued payloads, so a chunk that's stored then loaded
+	 * straight away always comes back with its latest data even if it
+	 * hasn't reached the disk yet.
+	 *
+	 * flush() blocks until everything stored so far is on disk. The
+	 * destructor does the same, so nothing is lost on shutdown.
+	 *
+	 * At most MAX_OPEN_REGIONS region files are kept open at once, the one
+	 * used longest ago is closed to make room for another and reopened
+	 * whenever it's needed again.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkStore store("Saves/save1", "map1");
+	 * store.store(chunk.getChunkPos(), chunk.save()); // returns straight away.
+	 *
+	 * data::Data payload;
+	 * if (store.load(ChunkPos(0, 0, 0), payload))
+	 * {
+	 *     chunk.load(payload);
+	 * }
+	 *
+	 * store.flush(); // everything is on disk after this.
+	 * @endcode
+	 */
+	class ChunkStore
+	{
+	public:
+		/**
+		 * @brief Starts a store for a map.
+		 * @param directory The directory the region files live in.
+		 * @param name The name of the map, used to name the region files.
+		 */
+		ChunkStore(std::string directory, std::string name);
+
+		/// @brief Writes anything that's still queued, then stops.
+		~ChunkStore();
+
+		ChunkStore(const ChunkStore&) = delete;
+		ChunkStore& operator=(const ChunkStore&) = delete;
+
+		/**
+		 * @brief Reads the payload of a chunk.
+		 * @param pos The position of the chunk.
+		 * @param payload Where to store the payload.
+		 * @return Whether the chunk has been saved before.
+		 */
+		bool load(const ChunkPos& pos, data::Data& payload);
+
+		/**
+		 * @brief Checks whether a chunk has been saved, or queued to be.
+		 * @param pos The position of the chunk.
+		 * @return Whether load() would find the chunk.
+		 */
+		bool contains(const ChunkPos& pos);
+
+		/**
+		 * @brief Queues the payload of a chunk to be written.
+		 * @param pos The position of the chunk.
+		 * @param payload The payload to write.
+		 */
+		void store(const ChunkPos& pos, data::Data payload);
+
+		/**
+		 * @brief Waits for every queued payload to be written.
+		 * @return Whether every write since the last flush succeeded.
+		 */
+		bool flush();
+
+		/// @brief Gets how many chunks are waiting to be written.
+		std::size_t getPendingCount();
+
+		/// @brief The most region files kept open at once.
+		static constexpr std::size_t MAX_OPEN_REGIONS = 16;
+
+	private:
+		struct OpenRegion
+		{
+			std::unique_ptr<RegionFile> file;
+			std::uint64_t               lastUsed = 0;
+		};
+
+		void run();
+
+		// m_regionMutex must be held. The region stays valid until the next
+		// call, which might close it.
+		RegionFile& getRegion(const ChunkPos& pos);
+
+		// m_regionMutex must be held.
+		void closeOldestRegion();
+
+	private:
+		std::string m_directory;
+		std::string m_name;
+
+		// guards the region files, held by the I/O thread for a whole batch
+		// so loads can't see half written batches.
+		std::mutex             m_regionMutex;
+		ChunkTable<OpenRegion> m_regions;
+		std::uint64_t          m_regionUses = 0;
+
+		// guards everything below, always lock m_regionMutex first if both
+		// are needed.
+		std::mutex              m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_written;
+		ChunkTable<data::Data>  m_pending;
+		std::uint64_t           m_queuedCount  = 0;
+		std::uint64_t           m_writtenCount = 0;
+		bool                    m_failed       = false;
+		bool                    m_stop         = false;
+
+		std::thread m_thread;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,350 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkTable.hpp
+ * @brief An open-addressing hash table keyed by chunk position.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Maps chunk positions to values with O(1) lookups.
+	 *
+	 * Chunk positions are packed into a single 64 bit integer (21 bits per
+	 * axis, so roughly a million chunks in each direction), which is then
+	 * hashed with a multiplicative hash and stored with linear probing in
+	 * a flat, power of two sized array. This avoids the node allocations
+	 * and float comparisons of an std::map keyed by math::vec3.
+	 *
+	 * Values are moved around when the table grows or when entries are
+	 * erased, so store something like an std::unique_ptr if references to
+	 * values need to stay valid.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkTable<int> table;
+	 * table[{0, 1, 0}] = 5;
+	 *
+	 * if (int* value = table.find({0, 1, 0}))
+	 * {
+	 *     std::cout << *value << std::endl;
+	 * }
+	 *
+	 * table.erase({0, 1, 0});
+	 * @endcode
+	 */
+	template <typename T>
+	class ChunkTable
+	{
+	public:
+		ChunkTable() = default;
+
+		/**
+		 * @brief Finds the value stored for a chunk.
+		 * @param pos The position of the chunk.
+		 * @return A pointer to the value, or nullptr if there isn't one.
+		 */
+		T* find(const ChunkPos& pos)
+		{
+			const std::size_t slot = findSlot(pack(pos));
+			return slot == NOT_FOUND ? nullptr : &m_slots[slot].value;
+		}
+
+		/// @copydoc find
+		const T* find(const ChunkPos& pos) const
+		{
+			const std::size_t slot = findSlot(pack(pos));
+			return slot == NOT_FOUND ? nullptr : &m_slots[slot].value;
+		}
+
+		/**
+		 * @brief Checks if a value is stored for a chunk.
+		 * @param pos The position of the chunk.
+		 * @return Whether the chunk is in the table.
+		 */
+		bool contains(const ChunkPos& pos) const
+		{
+			return findSlot(pack(pos)) != NOT_FOUND;
+		}
+
+		/**
+		 * @brief Gets the value for a chunk, default constructing it if it
+		 * doesn't exist.
+		 * @param pos The position of the chunk.
+		 * @return A reference to the value, valid until the table changes.
+		 */
+		T& operator[](const ChunkPos& pos)
+		{
+			const std::uint64_t key  = pack(pos);
+			std::size_t         slot = findSlot(key);
+			if (slot != NOT_FOUND)
+			{
+				return m_slots[slot].value;
+			}
+
+			// keep the load factor at or under 1/2 so probes stay short.
+			if ((m_size + 1) * 2 > m_slots.size())
+			{
+				rehash(m_slots.empty() ? MIN_CAPACITY : m_slots.size() * 2);
+			}
+
+			slot = indexFor(key);
+			while (m_slots[slot].key != EMPTY)
+			{
+				slot = (slot + 1) & (m_slots.size() - 1);
+			}
+
+			m_slots[slot].key   = key;
+			m_slots[slot].value = T();
+			++m_size;
+
+			return m_slots[slot].value;
+		}
+
+		/**
+		 * @brief Removes the value stored for a chunk.
+		 * @param pos The position of the chunk.
+		 * @return Whether there was a value to remove.
+		 */
+		bool erase(const ChunkPos& pos)
+		{
+			std::size_t hole = findSlot(pack(pos));
+			if (hole == NOT_FOUND)
+			{
+				return false;
+			}
+
+			// backward shift deletion, move any entries that probed past
+			// the hole back into it, so lookups never need tombstones.
+			const std::size_t mask = m_slots.size() - 1;
+			std::size_t       next = (hole + 1) & mask;
+			while (m_slots[next].key != EMPTY)
+			{
+				const std::size_t ideal = indexFor(m_slots[next].key);
+				if (((next - ideal) & mask) >= ((next - hole) & mask))
+				{
+					m_slots[hole] = std::move(m_slots[next]);
+					hole          = next;
+				}
+
+				next = (next + 1) & mask;
+			}
+
+			m_slots[hole].key   = EMPTY;
+			m_slots[hole].value = T();
+			--m_size;
+
+			return true;
+		}
+
+		/**
+		 * @brief Calls a function for every entry in the table.
+		 * @param func A function taking (const ChunkPos&, T&).
+		 *
+		 * The table must not be modified while iterating.
+		 */
+		template <typename F>
+		void forEach(F&& func)
+		{
+			for (Slot& slot : m_slots)
+			{
+				if (slot.key != EMPTY)
+				{
+					func(unpack(slot.key), slot.value);
+				}
+			}
+		}
+
+		/// @copydoc forEach
+		template <typename F>
+		void forEach(F&& func) const
+		{
+			for (const Slot& slot : m_slots)
+			{
+				if (slot.key != EMPTY)
+				{
+					func(unpack(slot.key), slot.value);
+				}
+			}
+		}
+
+		/**
+		 * @brief Makes sure a number of entries fit without rehashing.
+		 * @param count The number of entries to make room for.
+		 */
+		void reserve(std::size_t count)
+		{
+			std::size_t capacity = MIN_CAPACITY;
+			while (capacity < count * 2)
+			{
+				capacity *= 2;
+			}
+
+			if (capacity > m_slots.size())
+			{
+				rehash(capacity);
+			}
+		}
+
+		/// @brief Removes every entry from the table.
+		void clear()
+		{
+			m_slots.clear();
+			m_size  = 0;
+			m_shift = 64;
+		}
+
+		/// @brief Gets the number of entries in the table.
+		std::size_t size() const { return m_size; }
+
+		/// @brief Checks if the table has no entries.
+		bool empty() const { return m_size == 0; }
+
+		/**
+		 * @brief Packs a chunk position into a single integer.
+		 * @param pos The position to pack.
+		 * @return The position with 21 bits for each axis.
+		 */
+		static std::uint64_t pack(const ChunkPos& pos)
+		{
+			return ((static_cast<std::uint64_t>(pos.x) & AXIS_MASK)
+			        << (AXIS_BITS * 2)) |
+			       ((static_cast<std::uint64_t>(pos.y) & AXIS_MASK)
+			        << AXIS_BITS) |
+			       (static_cast<std::uint64_t>(pos.z) & AXIS_MASK);
+		}
+
+		/**
+		 * @brief Unpacks a position packed with pack().
+		 * @param key The packed position.
+		 * @return The chunk position.
+		 */
+		static ChunkPos unpack(std::uint64_t key)
+		{
+			return {signExtend(key >> (AXIS_BITS * 2)),
+			        signExtend(key >> AXIS_BITS), signExtend(key)};
+		}
+
+	private:
+		struct Slot
+		{
+			std::uint64_t key = EMPTY;
+			T             value {};
+		};
+
+		static constexpr std::uint64_t AXIS_BITS = CHUNK_POS_BITS;
+		static constexpr std::uint64_t AXIS_MASK = (1ull << AXIS_BITS) - 1;
+
+		// packed keys only use the bottom 63 bits, so this can never clash.
+		static constexpr std::uint64_t EMPTY        = ~0ull;
+		static constexpr std::size_t   NOT_FOUND    = ~std::size_t(0);
+		static constexpr std::size_t   MIN_CAPACITY = 16;
+
+		static int signExtend(std::uint64_t axis)
+		{
+			axis &= AXIS_MASK;
+			return static_cast<int>(static_cast<std::int64_t>(
+			                            axis << (64 - AXIS_BITS)) >>
+			                        (64 - AXIS_BITS));
+		}
+
+		std::size_t indexFor(std::uint64_t key) const
+		{
+			// fibonacci hashing, the top bits of the product are the best
+			// mixed so those are the ones used.
+			return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >>
+			                                m_shift);
+		}
+
+		std::size_t findSlot(std::uint64_t key) const
+		{
+			if (m_size == 0)
+			{
+				return NOT_FOUND;
+			}
+
+			std::size_t slot = indexFor(key);
+			while (m_slots[slot].key != EMPTY)
+			{
+				if (m_slots[slot].key == key)
+				{
+					return slot;
+				}
+
+				slot = (slot + 1) & (m_slots.size() - 1);
+			}
+
+			return NOT_FOUND;
+		}
+
+		void rehash(std::size_t capacity)
+		{
+			std::vector<Slot> old = std::move(m_slots);
+			m_slots               = std::vector<Slot>(capacity);
+
+			m_shift = 64;
+			while ((std::size_t(1) << (64 - m_shift)) < capacity)
+			{
+				--m_shift;
+			}
+
+			for (Slot& entry : old)
+			{
+				if (entry.key != EMPTY)
+				{
+					std::size_t slot = indexFor(entry.key);
+					while (m_slots[slot].key != EMPTY)
+					{
+						slot = (slot + 1) & (m_slots.size() - 1);
+					}
+
+					m_slots[slot] = std::move(entry);
+				}
+			}
+		}
+
+	private:
+		std::vector<Slot> m_slots;
+		std::size_t       m_size = 0;
+
+		// 64 - log2(capacity), the amount to shift hashes down by.
+		std::size_t m_shift = 64;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,169 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file Coordinates.hpp
+ * @brief Integer coordinate types for the voxel world.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+
+#include <algorithm>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The absolute position of a block in the world, in blocks.
+	 *
+	 * This is also used for positions of blocks relative to the chunk they
+	 * are in, in which case every component is within the chunk's size.
+	 */
+	using BlockPos = math::vec3i;
+
+	/**
+	 * @brief The position of a chunk in the world, in chunks.
+	 *
+	 * A chunk at ChunkPos(1, 0, -1) contains the blocks starting at
+	 * BlockPos(16, 0, -16).
+	 */
+	using ChunkPos = math::vec3i;
+
+	/// @brief log2 of the chunk width (x axis).
+	constexpr int CHUNK_WIDTH_SHIFT = 4;
+
+	/// @brief log2 of the chunk height (y axis).
+	constexpr int CHUNK_HEIGHT_SHIFT = 4;
+
+	/// @brief log2 of the chunk depth (z axis).
+	constexpr int CHUNK_DEPTH_SHIFT = 4;
+
+	/**
+	 * @brief How many bits of each chunk coordinate the world keeps.
+	 *
+	 * Chunks are keyed by their position packed into 64 bits (see
+	 * ChunkTable), chunks outside of this range would alias others.
+	 */
+	constexpr int CHUNK_POS_BITS = 21;
+
+	/// @brief The lowest chunk coordinate on any axis.
+	constexpr int MIN_CHUNK_POS = -(1 << (CHUNK_POS_BITS - 1));
+
+	/// @brief The highest chunk coordinate on any axis.
+	constexpr int MAX_CHUNK_POS = (1 << (CHUNK_POS_BITS - 1)) - 1;
+
+	// the decomposition below relies on >> being an arithmetic shift for
+	// negative numbers, which is implementation defined before C++20 but is
+	// what every compiler we support does.
+	static_assert((-17 >> 4) == -2, "Right shift must be arithmetic.");
+
+	/**
+	 * @brief Gets the chunk a block is in.
+	 * @param pos The absolute position of the block.
+	 * @return The position of the chunk containing the block.
+	 *
+	 * Since chunk sizes are powers of two, this is just a shift - which
+	 * also rounds negative positions down rather than towards zero.
+	 */
+	constexpr ChunkPos toChunkPos(const BlockPos& pos)
+	{
+		return {pos.x >> CHUNK_WIDTH_SHIFT, pos.y >> CHUNK_HEIGHT_SHIFT,
+		        pos.z >> CHUNK_DEPTH_SHIFT};
+	}
+
+	/**
+	 * @brief Gets the position of a block relative to its chunk.
+	 * @param pos The absolute position of the block.
+	 * @return The position of the block within its chunk.
+	 */
+	constexpr BlockPos toLocalPos(const BlockPos& pos)
+	{
+		return {pos.x & ((1 << CHUNK_WIDTH_SHIFT) - 1),
+		        pos.y & ((1 << CHUNK_HEIGHT_SHIFT) - 1),
+		        pos.z & ((1 << CHUNK_DEPTH_SHIFT) - 1)};
+	}
+
+	/**
+	 * @brief Gets the absolute position of the first block in a chunk.
+	 * @param chunk The position of the chunk.
+	 * @return The absolute position of the chunk's origin.
+	 */
+	constexpr BlockPos toBlockPos(const ChunkPos& chunk)
+	{
+		// multiplying rather than shifting since left shifting negatives is
+		// undefined, the compiler still emits a shift.
+		return {chunk.x * (1 << CHUNK_WIDTH_SHIFT),
+		        chunk.y * (1 << CHUNK_HEIGHT_SHIFT),
+		        chunk.z * (1 << CHUNK_DEPTH_SHIFT)};
+	}
+
+	/**
+	 * @brief Gets the block that contains a point in voxel space.
+	 * @param pos The point, in voxel-world units (not camera units).
+	 * @return The position of the block containing the point.
+	 */
+	inline BlockPos toBlockPos(const math::vec3& pos)
+	{
+		return {static_cast<int>(std::floor(pos.x)),
+		        static_cast<int>(std::floor(pos.y)),
+		        static_cast<int>(std::floor(pos.z))};
+	}
+
+	/**
+	 * @brief Checks whether a block is in a chunk the world can hold.
+	 * @param pos The absolute position of the block.
+	 * @return Whether the block's chunk is within MIN_CHUNK_POS and
+	 * MAX_CHUNK_POS on every axis.
+	 */
+	constexpr bool isInWorld(const BlockPos& pos)
+	{
+		const ChunkPos chunk = toChunkPos(pos);
+
+		return chunk.x >= MIN_CHUNK_POS && chunk.x <= MAX_CHUNK_POS &&
+		       chunk.y >= MIN_CHUNK_POS && chunk.y <= MAX_CHUNK_POS &&
+		       chunk.z >= MIN_CHUNK_POS && chunk.z <= MAX_CHUNK_POS;
+	}
+
+	/**
+	 * @brief Sorts the corners of a box, so one is the lowest on every axis.
+	 * @param min One corner of the box, set to the lowest corner.
+	 * @param max The opposite corner, set to the highest corner.
+	 */
+	inline void sortCorners(BlockPos& min, BlockPos& max)
+	{
+		const BlockPos low(std::min(min.x, max.x), std::min(min.y, max.y),
+		                   std::min(min.z, max.z));
+
+		max = {std::max(min.x, max.x), std::max(min.y, max.y),
+		       std::max(min.z, max.z)};
+		min = low;
+	}
+} // namespace phx::voxels
@@ -29,23 +29,274 @@
 #pragma once
 
 #include <Common/Math/Math.hpp>
+#include <Common/Voxels/BlockRegion.hpp>
 #include <Common/Voxels/Chunk.hpp>
-#include <map>
+#include <Common/Voxels/ChunkScheduler.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+#include <Common/Voxels/ChunkStore.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace phx
+{
+	class Setting;
+}
 
 namespace phx::voxels
 {
+	/**
+	 * @brief Holds the chunks of a map, loading and saving them as needed.
+	 *
+	 * Chunks are saved to region files in "Saves/<save>/", named
+	 * "<name>.<x>_<y>_<z>.region" after the position of the region (see
+	 * RegionFile). Old saves made of one text file per chunk are imported
+	 * into region files the first time the map is opened.
+	 *
+	 * Chunks that have never been saved are generated by a WorldGenerator,
+	 * seeded from "<name>.seed" in the save (a random seed is picked and
+	 * written there the first time). Generation is deterministic, so
+	 * generated chunks are only saved once they've been edited.
+	 *
+	 * Loading and generating happen on "map:generationThreads" worker
+	 * threads (see ChunkScheduler). requestChunk() asks for a chunk
+	 * without waiting for it, and tick() adds the chunks that have
+	 * finished to the map - everything already resident can be used as
+	 * normal in the meantime. getChunk() still works for any chunk, but
+	 * waits for it if it isn't resident yet.
+	 *
+	 * Edits only mark chunks as dirty. tick() saves the dirty chunks every
+	 * "map:saveInterval" milliseconds, and the disk writes themselves
+	 * happen on a background thread (see ChunkStore), so editing blocks
+	 * never waits on the disk. Destroying the map saves and flushes
+	 * everything.
+	 */
 	class Map
 	{
 	public:
 		Map(const std::string& save, const std::string& name);
+		~Map();
+
+		Map(Map&& other) noexcept = default;
+		Map& operator=(Map&& other) = delete;
+
+		/**
+		 * @brief Gets the seed the map's terrain is generated from.
+		 * @return The seed of the map.
+		 */
+		std::uint32_t getSeed() const { return m_generator->getSeed(); }
+
+		/**
+		 * @brief Gets a chunk, loading or generating it if required.
+		 * @param pos The position of the chunk.
+		 * @return A reference to the chunk.
+		 *
+		 * Chunks are never copied, the reference stays valid for as long
+		 * as the chunk is resident in the map. A chunk that isn't resident
+		 * is waited for, prefer requestChunk() where that can be avoided.
+		 */
+		Chunk& getChunk(const ChunkPos& pos);
+
+		/**
+		 * @brief Requests a chunk without waiting for it to load.
+		 * @param pos The position of the chunk.
+		 * @return The future of the chunk, ready straight away if the chunk
+		 * is resident.
+		 *
+		 * The chunk becomes resident on the first tick() after it's
+		 * loaded, requesting it again until then doesn't load it twice.
+		 */
+		ChunkScheduler::Result requestChunk(const ChunkPos& pos);
+
+		/**
+		 * @brief Gets the amount of chunks requested that aren't resident
+		 * yet.
+		 * @return The amount of chunks being loaded or generated.
+		 */
+		std::size_t getPendingChunkCount() const
+		{
+			return m_scheduler->getPendingCount();
+		}
+
+		/**
+		 * @brief Gets how many threads load and generate chunks.
+		 * @return The amount of generation threads.
+		 *
+		 * Anything else starting threads alongside the map (such as the
+		 * mesh workers) should leave these cores to the map.
+		 */
+		std::size_t getGenerationThreadCount() const
+		{
+			return m_scheduler->getThreadCount();
+		}
+
+		/**
+		 * @brief Finds a chunk without loading it.
+		 * @param pos The position of the chunk.
+		 * @return The chunk, or nullptr if it isn't resident.
+		 */
+		Chunk* findChunk(const ChunkPos& pos);
+
+		/// @copydoc findChunk
+		const Chunk* findChunk(const ChunkPos& pos) const;
+
+		/**
+		 * @brief Takes a snapshot of a chunk without loading it.
+		 * @param pos The position of the chunk.
+		 * @return The chunk as it is now, or nullptr if it isn't resident.
+		 *
+		 * The snapshot shares the chunk's blocks until the next edit, so
+		 * this is cheap enough to call for every mesh job. It stays valid
+		 * even after the chunk is unloaded.
+		 */
+		ChunkSnapshot getSnapshot(const ChunkPos& pos) const;
+
+		void setBlockAt(const BlockPos& pos, BlockType* block);
+
+		/**
+		 * @brief Sets every block in a box to the same block.
+		 * @param min One corner of the box, in blocks.
+		 * @param max The opposite corner, also inside the box.
+		 * @param block The block to fill the box with.
+		 * @return Whether the box was filled, see isUsableBox().
+		 *
+		 * This works a chunk at a time rather than block by block, see
+		 * Chunk::fill(). Chunks that aren't resident are loaded, all at
+		 * once on the generation threads.
+		 */
+		bool fill(const BlockPos& min, const BlockPos& max, BlockType* block);
+
+		/**
+		 * @brief Copies the blocks in a box.
+		 * @param min One corner of the box, in blocks.
+		 * @param max The opposite corner, also inside the box.
+		 * @return The registry IDs of every block in the box, or nothing if
+		 * the box isn't usable (see isUsableBox()).
+		 */
+		std::optional<BlockRegion> read(const BlockPos& min,
+		                                const BlockPos& max);
+
+		/**
+		 * @brief Copies a region of blocks into the map.
+		 * @param region The blocks to copy, such as from read().
+		 * @param origin Where the region's lowest corner goes, in blocks.
+		 * @return Whether the region was written, see isUsableBox().
+		 */
+		bool write(const BlockRegion& region, const BlockPos& origin);
 
-		Chunk getChunk(const math::vec3& pos);
-		void  setBlockAt(math::vec3 pos, BlockType* block);
-		void  save(const math::vec3& pos);
+		/**
+		 * @brief Checks whether fill(), read() and write() can work on a
+		 * box.
+		 * @param min One corner of the box, in blocks.
+		 * @param max The opposite corner, also inside the box.
+		 * @return Whether both corners are inside the world (see
+		 * isInWorld()) and the box holds at most MAX_REGION_VOLUME blocks.
+		 */
+		static bool isUsableBox(const BlockPos& min, const BlockPos& max);
+
+		/**
+		 * @brief The most blocks fill(), read() and write() work on at once.
+		 *
+		 * Anything bigger could load far more chunks than are ever kept
+		 * around, and allocate huge regions.
+		 */
+		static constexpr long long MAX_REGION_VOLUME = 128 * 128 * 128;
+
+		/**
+		 * @brief Unloads resident chunks, saving any unsaved edits first.
+		 * @param shouldUnload Picks the chunks to unload.
+		 * @return The amount of chunks that were unloaded.
+		 *
+		 * Unloaded chunks are only queued to be saved, not waited on - the
+		 * store hands back queued payloads, so getChunk() never reloads a
+		 * stale copy. Any reference to an unloaded chunk is left dangling.
+		 */
+		std::size_t unloadChunks(
+		    const std::function<bool(const ChunkPos&)>& shouldUnload);
+
+		/**
+		 * @brief Gets the amount of resident chunks.
+		 * @return The amount of resident chunks.
+		 */
+		std::size_t getChunkCount() const { return m_chunks.size(); }
+
+		/**
+		 * @brief Gets the memory used by the blocks of resident chunks.
+		 * @return Roughly how many bytes the resident chunks' blocks take.
+		 */
+		std::size_t getMemoryUsage() const;
+
+		/**
+		 * @brief Queues a chunk to be saved, without waiting for the disk.
+		 * @param pos The position of the chunk.
+		 */
+		void save(const ChunkPos& pos);
+
+		/**
+		 * @brief Adds the chunks that have finished loading, and saves the
+		 * dirty chunks if the save interval has passed.
+		 *
+		 * This should be called regularly (such as every frame) from the
+		 * thread that edits the map.
+		 */
+		void tick();
+
+		/**
+		 * @brief Saves every dirty chunk and waits for it to reach the disk.
+		 * @return Whether every chunk was written successfully.
+		 */
+		bool flush();
+
+		/**
+		 * @brief Imports chunks saved with the old text format.
+		 * @return The amount of chunks that were imported.
+		 *
+		 * Every "<name>.<x>_<y>_<z>.save" file in the save is written to
+		 * the matching region file, then renamed to end in ".imported" so
+		 * it's only ever imported once. This is run automatically when the
+		 * map is constructed.
+		 */
+		std::size_t importLegacySaves();
+
+		/**
+		 * @brief Reads the seed of a map, picking and saving one if there
+		 * isn't one yet.
+		 * @param save The name of the save the map is in.
+		 * @param name The name of the map.
+		 * @return The seed of the map.
+		 *
+		 * This is what the map generates its terrain from, anything else
+		 * generating chunks for the map needs to use the same seed.
+		 */
+		static std::uint32_t loadSeed(const std::string& save,
+		                              const std::string& name);
 
 	private:
-		std::map<math::vec3, Chunk, math::Vector3Key> m_chunks;
-		std::string                                   m_save;
-		std::string                                   m_mapName;
+		void saveDirty();
+
+		// adds the chunks the scheduler has finished to the map.
+		void adoptFinished();
+
+		// calls a function with every chunk a box of blocks overlaps,
+		// loading them if needed. Edits are marked dirty when edit is set.
+		void forEachChunk(const BlockPos& min, const BlockPos& max, bool edit,
+		                  const std::function<void(Chunk&)>& function);
+
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		ChunkTable<std::unique_ptr<Chunk>> m_chunks;
+		ChunkTable<bool>                   m_dirty;
+		std::unique_ptr<ChunkStore>        m_store;
+		std::unique_ptr<WorldGenerator>    m_generator;
+		std::unique_ptr<ChunkScheduler>    m_scheduler;
+		Setting*                           m_saveInterval;
+		Clock::time_point                  m_lastSave;
+		std::string                        m_save;
+		std::string                        m_mapName;
 	};
 } // namespace phx::voxels
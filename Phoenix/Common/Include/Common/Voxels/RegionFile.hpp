@@ -0,0 +1,212 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file RegionFile.hpp
+ * @brief Binary storage for groups of chunks on disk.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Serialization/SharedTypes.hpp>
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Stores the saved data of a 16x16x16 group of chunks in a single
+	 * file.
+	 *
+	 * Saving every chunk to its own file costs a file handle (and a couple
+	 * of filesystem entries) per chunk, so chunks are grouped into regions
+	 * instead. A region file starts with a header and an offset table, then
+	 * holds the chunk payloads one after another:
+	 *
+	 * @code
+	 * char[4]  magic     "PHXR"
+	 * uint32   version   RegionFile::VERSION
+	 * uint32   chunks    RegionFile::CHUNKS_PER_REGION
+	 * struct { uint32 offset; uint32 length; uint32 crc; } table[chunks]
+	 * ...      payloads
+	 * @endcode
+	 *
+	 * Every number is stored in network byte order. An offset of 0 means the
+	 * chunk hasn't been saved yet, and crc is the CRC-32 of the payload.
+	 * Version 1 files have no crc in their table, they're still read and
+	 * written but their payloads can't be checked.
+	 *
+	 * Payloads are never overwritten. Saving a chunk again appends the new
+	 * payload to the end of the file, and the table is only pointed at it
+	 * once it's been written - so a crash part way through leaves the old
+	 * payload in place, and a torn table entry fails its CRC.
+	 *
+	 * Once replaced payloads take up half the file, write() compacts it
+	 * (see compact()), so a chunk saved over and over doesn't grow its
+	 * region forever.
+	 *
+	 * The region file doesn't care what the payloads contain, see
+	 * Chunk::save() for the format of a chunk.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * RegionFile region("Saves/save1/map1.0_0_0.region");
+	 *
+	 * region.write(chunk.getChunkPos(), chunk.save());
+	 *
+	 * data::Data payload;
+	 * if (region.read(ChunkPos(1, 2, 3), payload))
+	 * {
+	 *     chunk.load(payload);
+	 * }
+	 * @endcode
+	 */
+	class RegionFile
+	{
+	public:
+		/// @brief How many chunks along each axis a region holds, as a shift.
+		static constexpr int REGION_SHIFT = 4;
+
+		/// @brief How many chunks along each axis a region holds.
+		static constexpr int REGION_SIZE = 1 << REGION_SHIFT;
+
+		/// @brief How many chunks a region holds.
+		static constexpr std::size_t CHUNKS_PER_REGION =
+		    REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+		/// @brief The version of the format written by this class.
+		static constexpr std::uint32_t VERSION = 2;
+
+		/**
+		 * @brief Opens a region file, creating it if it doesn't exist.
+		 * @param path The path of the region file.
+		 *
+		 * If the file exists but isn't a valid region (or was written by
+		 * a newer version) it's treated as empty and nothing is written to
+		 * it, so it can't be damaged any further.
+		 */
+		explicit RegionFile(const std::string& path);
+
+		RegionFile(const RegionFile&) = delete;
+		RegionFile& operator=(const RegionFile&) = delete;
+
+		/**
+		 * @brief Gets the position of the region that holds a chunk.
+		 * @param pos The position of the chunk, in chunks.
+		 * @return The position of the region, in regions.
+		 */
+		static ChunkPos toRegionPos(const ChunkPos& pos)
+		{
+			return {pos.x >> REGION_SHIFT, pos.y >> REGION_SHIFT,
+			        pos.z >> REGION_SHIFT};
+		}
+
+		/**
+		 * @brief Checks whether the file is a usable region file.
+		 * @return Whether chunks can be read from and written to the file.
+		 */
+		bool isValid() const { return m_valid; }
+
+		/**
+		 * @brief Checks whether a chunk has been saved in the region.
+		 * @param pos The position of the chunk, in chunks.
+		 * @return Whether the chunk has a payload in the file.
+		 */
+		bool contains(const ChunkPos& pos) const;
+
+		/**
+		 * @brief Reads the payload of a chunk.
+		 * @param pos The position of the chunk, in chunks.
+		 * @param payload Where to store the payload.
+		 * @return Whether the chunk was found and read, a payload that
+		 * doesn't match its CRC isn't read.
+		 */
+		bool read(const ChunkPos& pos, data::Data& payload);
+
+		/**
+		 * @brief Writes the payload of a chunk.
+		 * @param pos The position of the chunk, in chunks.
+		 * @param payload The payload to store.
+		 * @return Whether the payload was written.
+		 */
+		bool write(const ChunkPos& pos, const data::Data& payload);
+
+		/**
+		 * @brief Gets how much of the file is taken up by payloads that
+		 * have since been replaced.
+		 * @return The amount of bytes that compacting the file would free.
+		 */
+		std::uint32_t getWastedBytes() const { return m_wasted; }
+
+		/**
+		 * @brief Frees the space taken up by replaced payloads.
+		 * @return Whether the file was compacted.
+		 *
+		 * The live payloads are copied into a new file next to this one,
+		 * which is then renamed over it. A crash part way through leaves
+		 * the old file as it was. Version 1 files are upgraded to the
+		 * current version on the way.
+		 */
+		bool compact();
+
+	private:
+		struct Entry
+		{
+			std::uint32_t offset = 0;
+			std::uint32_t length = 0;
+			std::uint32_t crc    = 0;
+		};
+
+		static std::size_t indexOf(const ChunkPos& pos);
+
+		// the header of a current version file, holding the table.
+		static data::Data makeHeader(
+		    const std::array<Entry, CHUNKS_PER_REGION>& table);
+
+		bool readHeader();
+		void writeEntry(std::size_t index);
+
+		// the size of a table entry in the file's version.
+		std::size_t getEntrySize() const;
+
+	private:
+		std::string                          m_path;
+		std::fstream                         m_file;
+		std::array<Entry, CHUNKS_PER_REGION> m_table;
+		std::uint32_t                        m_version = VERSION;
+		std::uint32_t                        m_end     = 0;
+		std::uint32_t                        m_wasted  = 0;
+		bool                                 m_valid   = false;
+	};
+} // namespace phx::voxels
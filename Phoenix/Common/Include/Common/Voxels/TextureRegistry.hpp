@@ -29,7 +29,7 @@
 #pragma once
 
 #include <string>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 namespace phx::voxels
@@ -41,7 +41,7 @@ namespace phx::voxels
 	 * BlockRegistry. This class usually isn't used on it's own, for
 	 * example, Phoenix uses it in the BlockRegistry to hold texture paths.
 	 *
-	 * This class is essentially a wrapper on an unordered_set and
+	 * This class is essentially a wrapper on an unordered_map and
 	 * std::vector, provides very limited and simple functionality, however
 	 * it does all it actually needs to do.
 	 *
@@ -50,6 +50,9 @@ namespace phx::voxels
 	 * which further down the line saves on GPU memory (marginally but it
 	 * can add up).
 	 *
+	 * Every texture is given an index in the order it was first added,
+	 * which never changes - so it can be stored instead of the path.
+	 *
 	 * @paragraph Usage
 	 * @code
 	 * TextureRegistry registry;
@@ -75,21 +78,28 @@ namespace phx::voxels
 		/**
 		 * @brief Registers a texture within the texture registry.
 		 * @param texture The texture path to add.
+		 * @return The index of the texture, the existing index is returned
+		 * if it was already registered.
 		 */
-		void addTexture(const std::string& texture);
+		std::size_t addTexture(const std::string& texture);
 
 		/**
 		 * @brief Gets the Textures object.
-		 * @return An array of strings containing registered textures.
+		 * @return An array of strings containing registered textures, each
+		 * texture is at its index.
 		 */
 		std::vector<std::string> getTextures();
 
 	private:
 		/**
-		 * @brief The set of texture paths.
+		 * @brief The texture paths, in the order they were added.
+		 */
+		std::vector<std::string> m_textures;
+
+		/**
+		 * @brief The index of each texture path.
 		 *
-		 * @note We could have used an std::vector in this case (as done in
-		 * the BlockRegistry)
+		 * @note We could have used a search through m_textures instead
 		 *
 		 * @code
 		 * if (std::find(m_textures.begin(), m_textures.end(), texture) ==
@@ -101,11 +111,11 @@ namespace phx::voxels
 		 *
 		 * Here we are performing a search every time we insert an element,
 		 * so each one by itself is upto O(N) complexity, resulting in an
-		 * O(N*N) complexity overall. However, std::unordered_set has a
+		 * O(N*N) complexity overall. However, std::unordered_map has a
 		 * constant time look-up, giving the overall ~O(N) complexity.
 		 * - @beeperdeeper089
 		 */
-		std::unordered_set<std::string> m_textures;
+		std::unordered_map<std::string, std::size_t> m_indices;
 	};
 } // namespace phx::voxels
 
@@ -0,0 +1,206 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/**
+ * @file WorldGenerator.hpp
+ * @brief Seeded terrain generation for chunks that have never been saved.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Common/Math/Noise.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkTable.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief How much a WorldGenerator has generated, and how long each
+	 * stage took.
+	 *
+	 * The times are summed over every thread generating, so with several
+	 * threads they add up to more than the time that actually passed.
+	 */
+	struct WorldGeneratorStats
+	{
+		/// @brief The chunks generated.
+		std::size_t chunks = 0;
+		/// @brief The chunks skipped for being entirely above the ground.
+		std::size_t emptyChunks = 0;
+		/// @brief The columns of 2D noise built, each shared by every chunk
+		/// in the column.
+		std::size_t columns = 0;
+
+		/// @brief Time spent getting the heightmap of columns, mostly
+		/// spent building the ones that aren't cached.
+		std::chrono::nanoseconds heightmap {0};
+		/// @brief Time spent filling the ground in.
+		std::chrono::nanoseconds surface {0};
+		/// @brief Time spent carving caves.
+		std::chrono::nanoseconds caves {0};
+	};
+
+	/**
+	 * @brief Fills fresh chunks with terrain, the same seed always giving
+	 * the same world.
+	 *
+	 * Generation runs in stages, each only depending on the seed and the
+	 * position of the chunk:
+	 *
+	 * - Heightmap: a few octaves of 2D noise give the height of the ground
+	 *   in every column of blocks.
+	 * - Caves: where two 3D noise fields are both close to zero, tunnels
+	 *   are carved out of the ground below the soil.
+	 * - Surface: the ground is layered into grass on top, a few blocks of
+	 *   dirt (how many depends on more 2D noise) and stone underneath.
+	 *
+	 * Everything 2D is the same for every chunk in a column (chunks with the
+	 * same x and z), so it's worked out once per column and cached for the
+	 * chunks above and below to share. Chunks entirely above the ground
+	 * skip the 3D noise altogether.
+	 *
+	 * "core.grass", "core.dirt" and "core.stone" are used for the ground,
+	 * any that aren't registered fall back to the one above them. They're
+	 * looked up when the generator is constructed, so the block registry
+	 * has to be filled first.
+	 *
+	 * generate() can be called from several threads at once.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * WorldGenerator generator(seed);
+	 *
+	 * Chunk chunk(ChunkPos(0, -1, 0));
+	 * generator.generate(chunk);
+	 * @endcode
+	 */
+	class WorldGenerator
+	{
+	public:
+		/**
+		 * @brief Constructs a generator for a seed.
+		 * @param seed The seed of the world.
+		 */
+		explicit WorldGenerator(std::uint32_t seed);
+
+		WorldGenerator(const WorldGenerator&) = delete;
+		WorldGenerator& operator=(const WorldGenerator&) = delete;
+
+		/**
+		 * @brief Fills a chunk with the terrain at its position.
+		 * @param chunk The chunk to fill, it should be freshly constructed
+		 * (entirely air).
+		 */
+		void generate(Chunk& chunk);
+
+		/**
+		 * @brief Gets the seed of the world.
+		 * @return The seed the generator was constructed with.
+		 */
+		std::uint32_t getSeed() const { return m_seed; }
+
+		/**
+		 * @brief Gets the height of the ground at a block column.
+		 * @param x The x position of the column, in blocks.
+		 * @param z The z position of the column, in blocks.
+		 * @return The y position of the topmost block of ground, ignoring
+		 * caves.
+		 */
+		int getHeightAt(int x, int z);
+
+		/**
+		 * @brief Gets what's been generated so far.
+		 * @return The amount of chunks generated and the time each stage
+		 * took, since the generator was constructed.
+		 */
+		WorldGeneratorStats getStats() const;
+
+		/// @brief The most columns the cache holds before dropping the
+		/// oldest.
+		static constexpr std::size_t MAX_CACHED_COLUMNS = 1024;
+
+	private:
+		static constexpr int COLUMN_AREA = Chunk::CHUNK_WIDTH *
+		                                   Chunk::CHUNK_DEPTH;
+
+		// the 2D results for a column of chunks, x varying fastest.
+		struct Column
+		{
+			std::array<int, COLUMN_AREA>          height;
+			std::array<std::uint8_t, COLUMN_AREA> soilDepth;
+
+			int lowest;
+			int highest;
+		};
+
+		std::shared_ptr<const Column> getColumn(int x, int z);
+		std::unique_ptr<Column>       buildColumn(int x, int z) const;
+
+		// fills the ground in, the heightmap and surface stages.
+		void fillGround(Chunk& chunk, const Column& column) const;
+
+		// carves the caves out of the ground that's been filled in.
+		void carveCaves(Chunk& chunk, const Column& column) const;
+
+	private:
+		std::uint32_t m_seed;
+
+		math::Noise m_heightNoise;
+		math::Noise m_soilNoise;
+		math::Noise m_caveNoise;
+		math::Noise m_tunnelNoise;
+
+		std::size_t m_air;
+		std::size_t m_grass;
+		std::size_t m_dirt;
+		std::size_t m_stone;
+
+		// counted from every thread generating, times in nanoseconds.
+		std::atomic<std::size_t>   m_chunkCount {0};
+		std::atomic<std::size_t>   m_emptyCount {0};
+		std::atomic<std::size_t>   m_columnCount {0};
+		std::atomic<std::uint64_t> m_heightmapTime {0};
+		std::atomic<std::uint64_t> m_surfaceTime {0};
+		std::atomic<std::uint64_t> m_caveTime {0};
+
+		// guards the cache, columns themselves never change once built.
+		std::mutex                                m_mutex;
+		ChunkTable<std::shared_ptr<const Column>> m_columns;
+		std::deque<ChunkPos>                      m_columnOrder;
+	};
+} // namespace phx::voxels
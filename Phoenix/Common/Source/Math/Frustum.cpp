@@ -0,0 +1,187 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Math/Frustum.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define PHX_FRUSTUM_SSE
+#	include <xmmintrin.h>
+#endif
+
+using namespace phx::math;
+
+void AABBList::push(const vec3& min, const vec3& max)
+{
+	minX.push_back(min.x);
+	minY.push_back(min.y);
+	minZ.push_back(min.z);
+	maxX.push_back(max.x);
+	maxY.push_back(max.y);
+	maxZ.push_back(max.z);
+}
+
+void AABBList::clear()
+{
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
+
+Frustum::Frustum()
+{
+	// planes that everything is in front of.
+	for (float(&plane)[4] : m_planes)
+	{
+		plane[0] = 0.f;
+		plane[1] = 0.f;
+		plane[2] = 0.f;
+		plane[3] = 1.f;
+	}
+}
+
+Frustum::Frustum(const detail::Matrix4x4& viewProjection)
+{
+	// the matrix is column major, so row i is every 4th element from i.
+	const float* m = viewProjection.elements;
+
+	// a point is inside if -w <= x, y, z <= w once it's been transformed,
+	// so each plane is the last row plus or minus one of the others - in
+	// the order left, right, bottom, top, near, far.
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			m_planes[row * 2][i]     = m[3 + i * 4] + m[row + i * 4];
+			m_planes[row * 2 + 1][i] = m[3 + i * 4] - m[row + i * 4];
+		}
+	}
+}
+
+bool Frustum::intersects(const vec3& min, const vec3& max) const
+{
+	for (const float(&plane)[4] : m_planes)
+	{
+		// the corner of the box furthest along the plane's normal, if even
+		// that is behind the plane then so is the rest of the box.
+		const float x = plane[0] >= 0.f ? max.x : min.x;
+		const float y = plane[1] >= 0.f ? max.y : min.y;
+		const float z = plane[2] >= 0.f ? max.z : min.z;
+
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::size_t Frustum::intersects(const AABBList&            boxes,
+                                std::vector<std::uint8_t>& visible) const
+{
+	const std::size_t count = boxes.size();
+	visible.resize(count);
+
+	// which corner is furthest along a plane only depends on the plane, so
+	// pick the component arrays up front and the batch loop is just
+	// multiplies and adds.
+	const float* x[6];
+	const float* y[6];
+	const float* z[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		x[p] = m_planes[p][0] >= 0.f ? boxes.maxX.data() : boxes.minX.data();
+		y[p] = m_planes[p][1] >= 0.f ? boxes.maxY.data() : boxes.minY.data();
+		z[p] = m_planes[p][2] >= 0.f ? boxes.maxZ.data() : boxes.minZ.data();
+	}
+
+	std::size_t inside = 0;
+	std::size_t i      = 0;
+
+#ifdef PHX_FRUSTUM_SSE
+	__m128 a[6];
+	__m128 b[6];
+	__m128 c[6];
+	__m128 d[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		a[p] = _mm_set1_ps(m_planes[p][0]);
+		b[p] = _mm_set1_ps(m_planes[p][1]);
+		c[p] = _mm_set1_ps(m_planes[p][2]);
+		d[p] = _mm_set1_ps(m_planes[p][3]);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 outside = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_mul_ps(a[p], _mm_loadu_ps(x[p] + i));
+			distance =
+			    _mm_add_ps(distance, _mm_mul_ps(b[p], _mm_loadu_ps(y[p] + i)));
+			distance =
+			    _mm_add_ps(distance, _mm_mul_ps(c[p], _mm_loadu_ps(z[p] + i)));
+			distance = _mm_add_ps(distance, d[p]);
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+		}
+
+		const int mask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const std::uint8_t in = ((mask >> lane) & 1) == 0;
+
+			visible[i + lane] = in;
+			inside += in;
+		}
+	}
+#endif
+
+	// whatever doesn't fill a batch, or everything without SSE.
+	for (; i < count; ++i)
+	{
+		bool in = true;
+		for (int p = 0; p < 6 && in; ++p)
+		{
+			in = m_planes[p][0] * x[p][i] + m_planes[p][1] * y[p][i] +
+			         m_planes[p][2] * z[p][i] + m_planes[p][3] >=
+			     0.f;
+		}
+
+		visible[i] = in;
+		inside += in;
+	}
+
+	return inside;
+}
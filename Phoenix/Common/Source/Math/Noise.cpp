@@ -0,0 +1,426 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Math/Noise.hpp>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define PHX_NOISE_SSE2
+#	include <emmintrin.h>
+#	ifdef __SSE4_1__
+#		include <smmintrin.h>
+#	endif
+#endif
+
+using namespace phx::math;
+
+namespace
+{
+	// multipliers for spreading lattice coordinates over the hash.
+	constexpr std::uint32_t PRIME_X = 0x8da6b343u;
+	constexpr std::uint32_t PRIME_Y = 0xd8163841u;
+	constexpr std::uint32_t PRIME_Z = 0xcb1ab31fu;
+	constexpr std::uint32_t MIX     = 0x2c1b3c6du;
+
+	// brings the largest results of each kind of noise to about 1.
+	constexpr float SCALE_2D = 0.66f;
+	constexpr float SCALE_3D = 1.f;
+
+	// the scalar functions below have SSE2 twins further down. The
+	// floating point ones do exactly the same operations in the same
+	// order, keep them in step.
+
+	std::uint32_t hash(std::uint32_t seed, std::uint32_t x, std::uint32_t y,
+	                   std::uint32_t z)
+	{
+		std::uint32_t h = seed ^ (x * PRIME_X) ^ (y * PRIME_Y) ^ (z * PRIME_Z);
+
+		// only the top bits of a multiply depend on every bit of the input,
+		// so those pick the gradient.
+		h ^= h >> 16;
+		h *= MIX;
+		return h >> 28;
+	}
+
+	float fade(float t) { return t * t * t * (t * (t * 6.f - 15.f) + 10.f); }
+
+	float lerp(float a, float b, float t) { return a + t * (b - a); }
+
+	// eight gradients, (+-1, +-2) and (+-2, +-1).
+	float grad(std::uint32_t hash, float x, float y)
+	{
+		const std::uint32_t g = hash & 7u;
+
+		const float u = g < 4 ? x : y;
+		const float v = g < 4 ? y : x;
+
+		return ((g & 1u) ? -u : u) + ((g & 2u) ? -(v + v) : v + v);
+	}
+
+	// Perlin's twelve edge gradients, with four repeated to make sixteen.
+	float grad(std::uint32_t hash, float x, float y, float z)
+	{
+		const std::uint32_t g = hash & 15u;
+
+		const float u = g < 8 ? x : y;
+		const float v = g < 4 ? y : (g == 12 || g == 14 ? x : z);
+
+		return ((g & 1u) ? -u : u) + ((g & 2u) ? -v : v);
+	}
+
+	// a position split into its lattice cell and where it is in the cell.
+	struct Axis
+	{
+		std::uint32_t cell;
+		float         near;
+		float         far;
+		float         fade;
+
+		explicit Axis(float position)
+		{
+			const float floored = std::floor(position);
+
+			cell = static_cast<std::uint32_t>(static_cast<int>(floored));
+			near = position - floored;
+			far  = near - 1.f;
+			fade = ::fade(near);
+		}
+	};
+
+#ifdef PHX_NOISE_SSE2
+	__m128i mullo(__m128i a, __m128i b)
+	{
+#	ifdef __SSE4_1__
+		return _mm_mullo_epi32(a, b);
+#	else
+		// SSE2 has no 32 bit multiply, so the even and odd lanes are
+		// multiplied separately and their low halves put back together.
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd =
+		    _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+		return _mm_unpacklo_epi32(
+		    _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#	endif
+	}
+
+	__m128i splat(std::uint32_t value)
+	{
+		return _mm_set1_epi32(static_cast<int>(value));
+	}
+
+	// the second half of hash(), for when the lattice coordinates have
+	// already been combined.
+	__m128i finalize(__m128i h)
+	{
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+		h = mullo(h, splat(MIX));
+		return _mm_srli_epi32(h, 28);
+	}
+
+	__m128 fade(__m128 t)
+	{
+		const __m128 cube = _mm_mul_ps(_mm_mul_ps(t, t), t);
+		const __m128 poly = _mm_add_ps(
+		    _mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.f)),
+		                             _mm_set1_ps(15.f))),
+		    _mm_set1_ps(10.f));
+
+		return _mm_mul_ps(cube, poly);
+	}
+
+	__m128 lerp(__m128 a, __m128 b, __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+	}
+
+	__m128 select(__m128i mask, __m128 a, __m128 b)
+	{
+		const __m128 m = _mm_castsi128_ps(mask);
+		return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+	}
+
+	// flips the sign of every lane with the bit set, exactly as -v does.
+	__m128 negateIf(__m128i g, int bit, __m128 v)
+	{
+		const __m128i sign = _mm_slli_epi32(
+		    _mm_and_si128(g, _mm_set1_epi32(1 << bit)), 31 - bit);
+
+		return _mm_xor_ps(v, _mm_castsi128_ps(sign));
+	}
+
+	__m128 grad(__m128i hash, __m128 x, __m128 y)
+	{
+		const __m128i g    = _mm_and_si128(hash, _mm_set1_epi32(7));
+		const __m128i low4 = _mm_cmplt_epi32(g, _mm_set1_epi32(4));
+
+		const __m128 u = select(low4, x, y);
+		const __m128 v = select(low4, y, x);
+
+		return _mm_add_ps(negateIf(g, 0, u),
+		                  negateIf(g, 1, _mm_add_ps(v, v)));
+	}
+
+	__m128 grad(__m128i hash, __m128 x, __m128 y, __m128 z)
+	{
+		const __m128i g    = _mm_and_si128(hash, _mm_set1_epi32(15));
+		const __m128i low8 = _mm_cmplt_epi32(g, _mm_set1_epi32(8));
+		const __m128i low4 = _mm_cmplt_epi32(g, _mm_set1_epi32(4));
+		const __m128i useX =
+		    _mm_or_si128(_mm_cmpeq_epi32(g, _mm_set1_epi32(12)),
+		                 _mm_cmpeq_epi32(g, _mm_set1_epi32(14)));
+
+		const __m128 u = select(low8, x, y);
+		const __m128 v = select(low4, y, select(useX, x, z));
+
+		return _mm_add_ps(negateIf(g, 0, u), negateIf(g, 1, v));
+	}
+
+	// four positions along x, split the same way as Axis.
+	struct AxisX4
+	{
+		__m128i hashNear; // cell * PRIME_X
+		__m128i hashFar;  // (cell + 1) * PRIME_X
+		__m128  near;
+		__m128  far;
+		__m128  fade;
+
+		explicit AxisX4(__m128 position)
+		{
+			// truncate, then step back one for negative positions.
+			const __m128 truncated =
+			    _mm_cvtepi32_ps(_mm_cvttps_epi32(position));
+			const __m128 floored = _mm_sub_ps(
+			    truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, position),
+			                          _mm_set1_ps(1.f)));
+
+			hashNear = mullo(_mm_cvttps_epi32(floored), splat(PRIME_X));
+			hashFar  = _mm_add_epi32(hashNear, splat(PRIME_X));
+			near     = _mm_sub_ps(position, floored);
+			far      = _mm_sub_ps(near, _mm_set1_ps(1.f));
+			fade     = ::fade(near);
+		}
+	};
+#endif
+} // namespace
+
+Noise::Noise(std::uint32_t seed) : m_seed(seed) {}
+
+float Noise::at(float x, float y) const
+{
+	const Axis ax(x);
+	const Axis ay(y);
+
+	const float n00 =
+	    grad(hash(m_seed, ax.cell, ay.cell, 0), ax.near, ay.near);
+	const float n10 =
+	    grad(hash(m_seed, ax.cell + 1, ay.cell, 0), ax.far, ay.near);
+	const float n01 =
+	    grad(hash(m_seed, ax.cell, ay.cell + 1, 0), ax.near, ay.far);
+	const float n11 =
+	    grad(hash(m_seed, ax.cell + 1, ay.cell + 1, 0), ax.far, ay.far);
+
+	return lerp(lerp(n00, n10, ax.fade), lerp(n01, n11, ax.fade), ay.fade) *
+	       SCALE_2D;
+}
+
+float Noise::at(float x, float y, float z) const
+{
+	const Axis ax(x);
+	const Axis ay(y);
+	const Axis az(z);
+
+	float corners[2][2];
+	for (int k = 0; k < 2; ++k)
+	{
+		const std::uint32_t cz = az.cell + k;
+		const float         dz = k == 0 ? az.near : az.far;
+
+		for (int j = 0; j < 2; ++j)
+		{
+			const std::uint32_t cy = ay.cell + j;
+			const float         dy = j == 0 ? ay.near : ay.far;
+
+			const float n0 =
+			    grad(hash(m_seed, ax.cell, cy, cz), ax.near, dy, dz);
+			const float n1 =
+			    grad(hash(m_seed, ax.cell + 1, cy, cz), ax.far, dy, dz);
+
+			corners[k][j] = lerp(n0, n1, ax.fade);
+		}
+	}
+
+	const float near = lerp(corners[0][0], corners[0][1], ay.fade);
+	const float far  = lerp(corners[1][0], corners[1][1], ay.fade);
+
+	return lerp(near, far, az.fade) * SCALE_3D;
+}
+
+void Noise::fill2D(float* out, float x, float y, int width, int height,
+                   float frequency) const
+{
+#ifdef PHX_NOISE_SSE2
+	const __m128 scale = _mm_set1_ps(frequency);
+	const __m128 steps = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+#endif
+
+	for (int j = 0; j < height; ++j)
+	{
+		const float sampleY = (y + static_cast<float>(j)) * frequency;
+
+		int i = 0;
+#ifdef PHX_NOISE_SSE2
+		// everything but x is the same along a row, so it's only worked
+		// out once per row.
+		const Axis ay(sampleY);
+
+		const __m128i rowNear = splat(m_seed ^ (ay.cell * PRIME_Y));
+		const __m128i rowFar  = splat(m_seed ^ ((ay.cell + 1) * PRIME_Y));
+		const __m128  dyNear  = _mm_set1_ps(ay.near);
+		const __m128  dyFar   = _mm_set1_ps(ay.far);
+		const __m128  fadeY   = _mm_set1_ps(ay.fade);
+
+		for (; i + 4 <= width; i += 4)
+		{
+			const __m128 column =
+			    _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), steps);
+			const AxisX4 ax(
+			    _mm_mul_ps(_mm_add_ps(_mm_set1_ps(x), column), scale));
+
+			const __m128 n00 =
+			    grad(finalize(_mm_xor_si128(rowNear, ax.hashNear)), ax.near,
+			         dyNear);
+			const __m128 n10 = grad(
+			    finalize(_mm_xor_si128(rowNear, ax.hashFar)), ax.far, dyNear);
+			const __m128 n01 = grad(
+			    finalize(_mm_xor_si128(rowFar, ax.hashNear)), ax.near, dyFar);
+			const __m128 n11 = grad(
+			    finalize(_mm_xor_si128(rowFar, ax.hashFar)), ax.far, dyFar);
+
+			const __m128 value = lerp(lerp(n00, n10, ax.fade),
+			                          lerp(n01, n11, ax.fade), fadeY);
+
+			_mm_storeu_ps(out + i, _mm_mul_ps(value, _mm_set1_ps(SCALE_2D)));
+		}
+#endif
+
+		// whatever doesn't fill a batch, or everything without SSE2.
+		for (; i < width; ++i)
+		{
+			out[i] = at((x + static_cast<float>(i)) * frequency, sampleY);
+		}
+
+		out += width;
+	}
+}
+
+void Noise::fill3D(float* out, float x, float y, float z, int width,
+                   int height, int depth, float frequency) const
+{
+#ifdef PHX_NOISE_SSE2
+	const __m128 scale = _mm_set1_ps(frequency);
+	const __m128 steps = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+#endif
+
+	for (int k = 0; k < depth; ++k)
+	{
+		const float sampleZ = (z + static_cast<float>(k)) * frequency;
+
+		for (int j = 0; j < height; ++j)
+		{
+			const float sampleY = (y + static_cast<float>(j)) * frequency;
+
+			int i = 0;
+#ifdef PHX_NOISE_SSE2
+			const Axis ay(sampleY);
+			const Axis az(sampleZ);
+
+			// the y and z part of the hash of each corner, in the same
+			// order at() visits them.
+			__m128i rows[2][2];
+			__m128  dy[2];
+			__m128  dz[2];
+			for (int c = 0; c < 2; ++c)
+			{
+				for (int r = 0; r < 2; ++r)
+				{
+					rows[c][r] = splat(m_seed ^ ((ay.cell + r) * PRIME_Y) ^
+					                   ((az.cell + c) * PRIME_Z));
+				}
+
+				dy[c] = _mm_set1_ps(c == 0 ? ay.near : ay.far);
+				dz[c] = _mm_set1_ps(c == 0 ? az.near : az.far);
+			}
+
+			const __m128 fadeY = _mm_set1_ps(ay.fade);
+			const __m128 fadeZ = _mm_set1_ps(az.fade);
+
+			for (; i + 4 <= width; i += 4)
+			{
+				const __m128 column =
+				    _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), steps);
+				const AxisX4 ax(
+				    _mm_mul_ps(_mm_add_ps(_mm_set1_ps(x), column), scale));
+
+				__m128 corners[2][2];
+				for (int c = 0; c < 2; ++c)
+				{
+					for (int r = 0; r < 2; ++r)
+					{
+						const __m128 n0 = grad(
+						    finalize(_mm_xor_si128(rows[c][r], ax.hashNear)),
+						    ax.near, dy[r], dz[c]);
+						const __m128 n1 = grad(
+						    finalize(_mm_xor_si128(rows[c][r], ax.hashFar)),
+						    ax.far, dy[r], dz[c]);
+
+						corners[c][r] = lerp(n0, n1, ax.fade);
+					}
+				}
+
+				const __m128 near = lerp(corners[0][0], corners[0][1], fadeY);
+				const __m128 far  = lerp(corners[1][0], corners[1][1], fadeY);
+
+				_mm_storeu_ps(out + i, _mm_mul_ps(lerp(near, far, fadeZ),
+				                                  _mm_set1_ps(SCALE_3D)));
+			}
+#endif
+
+			for (; i < width; ++i)
+			{
+				out[i] = at((x + static_cast<float>(i)) * frequency, sampleY,
+				            sampleZ);
+			}
+
+			out += width;
+		}
+	}
+}
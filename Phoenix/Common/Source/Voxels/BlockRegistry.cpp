@@ -26,11 +26,9 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <Common/Logger.hpp>
 #include <Common/Voxels/BlockRegistry.hpp>
 
-#include <algorithm>
-#include <cstring>
-
 using namespace phx::voxels;
 
 BlockRegistry::BlockRegistry()
@@ -111,31 +109,57 @@ void BlockRegistry::registerAPI(phx::cms::ModManager* manager)
 
 void BlockRegistry::registerBlock(BlockType blockInfo)
 {
-	if (std::find(m_blocks.begin(), m_blocks.end(), blockInfo) ==
-	    m_blocks.end())
+	if (m_blocks.size() >= MAX_BLOCKS)
+	{
+		LOG_WARNING("MODDING") << "Block " << blockInfo.id
+		                       << " wasn't registered, there can only be "
+		                       << MAX_BLOCKS << " blocks.";
+		return;
+	}
+
+	// emplace doesn't overwrite, so the first block registered with an ID
+	// wins - just like when this was a search through m_blocks.
+	if (m_ids.emplace(blockInfo.id, m_blocks.size()).second)
 	{
 		blockInfo.m_registryID = m_blocks.size();
-		m_blocks.push_back(blockInfo);
 
+		BlockProperties::FaceTextures textures;
+		textures.fill(BlockProperties::NO_TEXTURE);
 		if (blockInfo.category != BlockCategory::AIR)
 		{
-			for (const std::string& tex : blockInfo.textures)
+			for (std::size_t i = 0; i < textures.size(); ++i)
 			{
-				m_textures.addTexture(tex);
+				textures[i] = static_cast<std::uint16_t>(
+				    m_textures.addTexture(blockInfo.textures[i]));
 			}
 		}
+
+		m_properties.add(blockInfo, textures);
+		m_blocks.push_back(std::move(blockInfo));
 	}
 }
 
 BlockType* BlockRegistry::getFromID(const std::string& id)
 {
-	auto it = std::find_if(
-	    m_blocks.begin(), m_blocks.end(), [id](const BlockType& block) {
-		    return std::strcmp(block.id.c_str(), id.c_str()) == 0;
-	    });
+	const auto it = m_ids.find(id);
+
+	return it == m_ids.end() ? getFromRegistryID(UNKNOWN_BLOCK)
+	                         : &m_blocks[it->second];
+}
+
+std::vector<std::size_t> BlockRegistry::resolvePalette(
+    const std::vector<std::string>& ids) const
+{
+	std::vector<std::size_t> registryIDs;
+	registryIDs.reserve(ids.size());
+
+	for (const std::string& id : ids)
+	{
+		const auto it = m_ids.find(id);
+		registryIDs.push_back(it == m_ids.end() ? UNKNOWN_BLOCK : it->second);
+	}
 
-	return it == m_blocks.end() ? getFromRegistryID(0)
-	                            : &(*it); // 0 is always unknown.
+	return registryIDs;
 }
 
 BlockType* BlockRegistry::getFromRegistryID(std::size_t registryID)
@@ -0,0 +1,214 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockStorage.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+
+// the next index width up, widths go 0 (uniform), 1, 2, 4, 8 then 16 bits.
+static std::size_t nextWidth(std::size_t bits)
+{
+	return bits == 0 ? 1 : bits * 2;
+}
+
+// how many bits are needed to index a palette of the provided size, rounded
+// up to a power of two so indices never straddle words.
+static std::size_t bitsForPalette(std::size_t paletteSize)
+{
+	std::size_t bits = 0;
+	while ((std::size_t(1) << bits) < paletteSize)
+	{
+		bits = nextWidth(bits);
+	}
+
+	return bits;
+}
+
+// the amount of words needed to pack the indices. Uniform storage keeps a
+// single zero word around so reads stay branchless - with a width and mask
+// of 0 every read lands on palette index 0.
+static std::size_t wordsFor(std::size_t size, std::size_t bits,
+                            std::size_t wordBits)
+{
+	return bits == 0 ? 1 : (size * bits + wordBits - 1) / wordBits;
+}
+
+BlockStorage::BlockStorage(std::size_t size, std::size_t fill) : m_size(size)
+{
+	BlockStorage::fill(fill);
+}
+
+void BlockStorage::set(std::size_t index, std::size_t id)
+{
+	writeIndex(index, paletteIndexOf(id));
+}
+
+void BlockStorage::fill(std::size_t id)
+{
+	m_bits    = 0;
+	m_mask    = 0;
+	m_palette = {id};
+	m_data    = std::vector<Word>(1, 0);
+}
+
+void BlockStorage::compact()
+{
+	std::vector<std::size_t> used(m_palette.size(), 0);
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		++used[readIndex(i)];
+	}
+
+	if (std::find(used.begin(), used.end(), 0) == used.end())
+	{
+		return;
+	}
+
+	// work out where each of the surviving entries end up.
+	std::vector<std::size_t> palette;
+	std::vector<std::size_t> remap(m_palette.size(), 0);
+	for (std::size_t i = 0; i < m_palette.size(); ++i)
+	{
+		if (used[i] != 0)
+		{
+			remap[i] = palette.size();
+			palette.push_back(m_palette[i]);
+		}
+	}
+
+	std::vector<std::size_t> indices(m_size);
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		indices[i] = remap[readIndex(i)];
+	}
+
+	m_palette = std::move(palette);
+	pack(bitsForPalette(m_palette.size()), indices);
+}
+
+bool BlockStorage::load(std::vector<std::size_t> palette, std::size_t bits,
+                        std::vector<Word> data)
+{
+	if (palette.empty() || bits != bitsForPalette(palette.size()) ||
+	    data.size() != wordsFor(m_size, bits, WORD_BITS))
+	{
+		return false;
+	}
+
+	const Word mask = (Word(1) << bits) - 1;
+
+	// make sure nothing points past the end of the palette, otherwise a
+	// corrupt file would turn into out of bounds reads later on.
+	for (std::size_t i = 0; i < m_size && bits != 0; ++i)
+	{
+		const std::size_t bit = i * bits;
+		if (((data[bit / WORD_BITS] >> (bit % WORD_BITS)) & mask) >=
+		    palette.size())
+		{
+			return false;
+		}
+	}
+
+	m_bits    = bits;
+	m_mask    = mask;
+	m_palette = std::move(palette);
+	m_data    = std::move(data);
+
+	return true;
+}
+
+std::size_t BlockStorage::getMemoryUsage() const
+{
+	return sizeof(BlockStorage) + m_palette.capacity() * sizeof(std::size_t) +
+	       m_data.capacity() * sizeof(Word);
+}
+
+void BlockStorage::writeIndex(std::size_t index, std::size_t value)
+{
+	const std::size_t bit   = index * m_bits;
+	const std::size_t shift = bit % WORD_BITS;
+	Word&             word  = m_data[bit / WORD_BITS];
+
+	word = (word & ~(m_mask << shift)) | (static_cast<Word>(value) << shift);
+}
+
+std::size_t BlockStorage::paletteIndexOf(std::size_t id)
+{
+	const auto it = std::find(m_palette.begin(), m_palette.end(), id);
+	if (it != m_palette.end())
+	{
+		return static_cast<std::size_t>(it - m_palette.begin());
+	}
+
+	if (m_palette.size() == (std::size_t(1) << m_bits))
+	{
+		// try to make room by dropping unused entries before widening, a
+		// uniform storage has nothing to drop so is promoted straight away.
+		if (m_bits != 0)
+		{
+			compact();
+		}
+
+		if (m_palette.size() == (std::size_t(1) << m_bits))
+		{
+			resize(nextWidth(m_bits));
+		}
+	}
+
+	m_palette.push_back(id);
+	return m_palette.size() - 1;
+}
+
+void BlockStorage::resize(std::size_t bits)
+{
+	std::vector<std::size_t> indices(m_size);
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		indices[i] = readIndex(i);
+	}
+
+	pack(bits, indices);
+}
+
+void BlockStorage::pack(std::size_t                     bits,
+                        const std::vector<std::size_t>& indices)
+{
+	m_bits = bits;
+	m_mask = (Word(1) << bits) - 1;
+
+	// assigning a fresh vector rather than using assign() lets the memory
+	// be given back when the width shrinks.
+	m_data = std::vector<Word>(wordsFor(m_size, bits, WORD_BITS), 0);
+
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		writeIndex(i, indices[i]);
+	}
+}
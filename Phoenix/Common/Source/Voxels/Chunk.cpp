@@ -26,76 +26,309 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <Common/Serialization/BinaryIO.hpp>
 #include <Common/Voxels/BlockRegistry.hpp>
 #include <Common/Voxels/Chunk.hpp>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
 using namespace phx::voxels;
+using namespace phx;
 
-Chunk::Chunk(const phx::math::vec3& chunkPos) : m_pos(chunkPos)
+namespace
+{
+	// clips a box in world blocks to a chunk, leaving the part inside the
+	// chunk relative to it. Returns false if none of the box is inside.
+	bool clipToChunk(const ChunkPos& chunk, BlockPos& min, BlockPos& max)
+	{
+		const BlockPos origin = toBlockPos(chunk);
+
+		min = min - origin;
+		max = max - origin;
+
+		min.x = std::max(min.x, 0);
+		min.y = std::max(min.y, 0);
+		min.z = std::max(min.z, 0);
+		max.x = std::min(max.x, Chunk::CHUNK_WIDTH - 1);
+		max.y = std::min(max.y, Chunk::CHUNK_HEIGHT - 1);
+		max.z = std::min(max.z, Chunk::CHUNK_DEPTH - 1);
+
+		return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+	}
+} // namespace
+
+Chunk::Chunk(const ChunkPos& chunkPos)
+    : m_pos(chunkPos),
+      m_blocks(std::make_shared<BlockStorage>(
+          CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH,
+          BlockRegistry::get()->getFromID("core.air")->getRegistryID()))
 {
-	m_blocks.reserve(CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH);
 }
 
-Chunk::Chunk(const phx::math::vec3& chunkPos, const std::string& save)
-    : m_pos(chunkPos)
+Chunk::Chunk(const ChunkPos& chunkPos, const std::string& save)
+    : Chunk(chunkPos)
 {
+	// split the save into palette indices first, so each distinct ID only
+	// has to be resolved once rather than once per block.
+	std::vector<std::string>                          ids;
+	std::unordered_map<std::string_view, std::size_t> palette;
+	std::vector<std::size_t>                          indices;
+	indices.reserve(m_blocks->size());
+
 	std::string_view search = save;
 	size_t           pos;
-	while ((pos = search.find_first_of(';')) != std::string_view::npos)
+	while ((pos = search.find_first_of(';')) != std::string_view::npos &&
+	       indices.size() < m_blocks->size())
 	{
-		std::string result;
-		result = search.substr(0, pos);
-		m_blocks.push_back(BlockRegistry::get()->getFromID(result));
+		const auto entry = palette.emplace(search.substr(0, pos), ids.size());
+		if (entry.second)
+		{
+			ids.emplace_back(entry.first->first);
+		}
+
+		indices.push_back(entry.first->second);
 		search.remove_prefix(pos + 1);
 	}
+
+	const std::vector<std::size_t> registryIDs =
+	    BlockRegistry::get()->resolvePalette(ids);
+
+	BlockStorage& blocks = editBlocks();
+	for (std::size_t i = 0; i < indices.size(); ++i)
+	{
+		blocks.set(i, registryIDs[indices[i]]);
+	}
 }
 
-std::string Chunk::save()
+void Chunk::compact()
 {
-	std::string save;
-	for (BlockType* block : m_blocks)
+	// compacting doesn't change any blocks, so if a snapshot is sharing
+	// them it's not worth duplicating them just for this.
+	if (m_blocks.use_count() == 1)
 	{
-		save += block->id;
-		save += ";";
+		std::atomic_thread_fence(std::memory_order_acquire);
+		m_blocks->compact();
 	}
-	return save;
 }
 
-void Chunk::autoTestFill()
+data::Data Chunk::save() const
 {
-	BlockType* block = BlockRegistry::get()->getFromID("core.air");
-	if (m_pos.y < 16 && m_pos.y >= 0.f)
+	static_assert(CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH <=
+	                  std::numeric_limits<std::uint16_t>::max(),
+	              "A compacted palette must fit the 16 bit palette size.");
+
+	// the palette size is saved in 16 bits, which only IDs no block uses
+	// anymore can take it past. Those are dropped from a copy in that
+	// (rare) case, rather than widening the format for it.
+	const BlockStorage*         blocks = m_blocks.get();
+	std::optional<BlockStorage> compacted;
+	if (blocks->getPalette().size() > std::numeric_limits<std::uint16_t>::max())
+	{
+		compacted.emplace(*blocks);
+		compacted->compact();
+		blocks = &*compacted;
+	}
+
+	const std::vector<std::size_t>&   palette = blocks->getPalette();
+	const std::vector<std::uint64_t>& words   = blocks->getData();
+
+	data::BinaryWriter writer;
+	writer.reserve(words.size() * sizeof(std::uint64_t) + palette.size() * 32);
+
+	writer.write(static_cast<std::uint16_t>(palette.size()));
+	for (std::size_t id : palette)
 	{
-		block = BlockRegistry::get()->getFromID("core.grass");
+		writer.writeString(BlockRegistry::get()->getFromRegistryID(id)->id);
 	}
 
-	for (std::size_t i = 0; i < CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH; ++i)
+	writer.write(static_cast<std::uint8_t>(blocks->getBitsPerIndex()));
+	writer.write(static_cast<std::uint32_t>(words.size()));
+	for (std::uint64_t word : words)
 	{
-		m_blocks.push_back(block);
+		writer.write(word);
 	}
+
+	return std::move(writer.getBuffer());
 }
 
-phx::math::vec3          Chunk::getChunkPos() const { return m_pos; }
-std::vector<BlockType*>& Chunk::getBlocks() { return m_blocks; }
+bool Chunk::load(const data::Data& payload)
+{
+	data::BinaryReader reader(payload);
 
-BlockType* Chunk::getBlockAt(phx::math::vec3 position) const
+	std::uint16_t paletteSize = 0;
+	reader.read(paletteSize);
+
+	std::vector<std::string> ids(paletteSize);
+	for (std::string& id : ids)
+	{
+		reader.readString(id);
+	}
+
+	// unknown IDs (like ones from mods that have been removed) resolve to
+	// core.unknown, like they did with the text format.
+	std::vector<std::size_t> palette =
+	    BlockRegistry::get()->resolvePalette(ids);
+
+	std::uint8_t  bits      = 0;
+	std::uint32_t wordCount = 0;
+	reader.read(bits);
+	reader.read(wordCount);
+
+	// a valid word count is tiny, checking against what's left stops a
+	// corrupt count from allocating gigabytes.
+	if (!reader.good() ||
+	    wordCount > reader.remaining() / sizeof(std::uint64_t))
+	{
+		return false;
+	}
+
+	std::vector<std::uint64_t> words(wordCount);
+	for (std::uint64_t& word : words)
+	{
+		reader.read(word);
+	}
+
+	return editBlocks().load(std::move(palette), bits, std::move(words));
+}
+
+ChunkPos            Chunk::getChunkPos() const { return m_pos; }
+const BlockStorage& Chunk::getBlocks() const { return *m_blocks; }
+
+BlockType* Chunk::getBlockAt(const BlockPos& position) const
 {
-	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
-	    position.z < CHUNK_DEPTH)
+	if (isInBounds(position))
 	{
-		return m_blocks[getVectorIndex(position)];
+		return BlockRegistry::get()->getFromRegistryID(
+		    m_blocks->get(getVectorIndex(position)));
 	}
 
 	return BlockRegistry::get()->getFromRegistryID(
 	    1); // 1 is always out of bounds
 }
 
-void Chunk::setBlockAt(phx::math::vec3 position, BlockType* newBlock)
+std::size_t Chunk::getBlockIDAt(const BlockPos& position) const
 {
-	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
-	    position.z < CHUNK_DEPTH)
+	if (isInBounds(position))
 	{
-		m_blocks[getVectorIndex(position)] = newBlock;
+		return m_blocks->get(getVectorIndex(position));
 	}
+
+	return BlockRegistry::OUT_OF_BOUNDS_BLOCK;
+}
+
+void Chunk::setBlockAt(const BlockPos& position, BlockType* newBlock)
+{
+	if (isInBounds(position))
+	{
+		editBlocks().set(getVectorIndex(position), newBlock->getRegistryID());
+	}
+}
+
+void Chunk::fill(const BlockPos& min, const BlockPos& max, BlockType* block)
+{
+	BlockPos low  = min;
+	BlockPos high = max;
+	if (!clipToChunk(m_pos, low, high))
+	{
+		return;
+	}
+
+	const std::size_t id = block->getRegistryID();
+
+	// the old blocks don't matter when they're all replaced, so rather
+	// than copying them out of a snapshot they're dropped.
+	const BlockPos last(CHUNK_WIDTH - 1, CHUNK_HEIGHT - 1, CHUNK_DEPTH - 1);
+	if (low == BlockPos(0, 0, 0) && high == last)
+	{
+		m_blocks = std::make_shared<BlockStorage>(
+		    CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH, id);
+		++m_version;
+		return;
+	}
+
+	BlockStorage& blocks = editBlocks();
+
+	for (int z = low.z; z <= high.z; ++z)
+	{
+		for (int y = low.y; y <= high.y; ++y)
+		{
+			for (int x = low.x; x <= high.x; ++x)
+			{
+				blocks.set(getVectorIndex(x, y, z), id);
+			}
+		}
+	}
+}
+
+void Chunk::read(BlockRegion& region) const
+{
+	BlockPos low  = region.getMin();
+	BlockPos high = region.getMax();
+	if (!clipToChunk(m_pos, low, high))
+	{
+		return;
+	}
+
+	// where the chunk's first block is, relative to the region.
+	const BlockPos offset = toBlockPos(m_pos) - region.getMin();
+
+	for (int z = low.z; z <= high.z; ++z)
+	{
+		for (int y = low.y; y <= high.y; ++y)
+		{
+			for (int x = low.x; x <= high.x; ++x)
+			{
+				region.setBlockIDAt(offset + BlockPos(x, y, z),
+				                    m_blocks->get(getVectorIndex(x, y, z)));
+			}
+		}
+	}
+}
+
+void Chunk::write(const BlockRegion& region, const BlockPos& origin)
+{
+	BlockPos low  = origin;
+	BlockPos high = origin + region.getSize() - 1;
+	if (!clipToChunk(m_pos, low, high))
+	{
+		return;
+	}
+
+	const BlockPos offset = toBlockPos(m_pos) - origin;
+	BlockStorage&  blocks = editBlocks();
+
+	for (int z = low.z; z <= high.z; ++z)
+	{
+		for (int y = low.y; y <= high.y; ++y)
+		{
+			for (int x = low.x; x <= high.x; ++x)
+			{
+				blocks.set(getVectorIndex(x, y, z),
+				           region.getBlockIDAt(offset + BlockPos(x, y, z)));
+			}
+		}
+	}
+}
+
+BlockStorage& Chunk::editBlocks()
+{
+	// copies are only ever made from the thread that owns this chunk, so
+	// a count of one can't go back up behind our back. The fence makes
+	// sure whoever dropped the last other copy is done reading it.
+	if (m_blocks.use_count() == 1)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+	else
+	{
+		m_blocks = std::make_shared<BlockStorage>(*m_blocks);
+	}
+
+	++m_version;
+	return *m_blocks;
 }
@@ -0,0 +1,262 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Voxels/ChunkScheduler.hpp>
+
+#include <exception>
+#include <utility>
+
+using namespace phx::voxels;
+using namespace phx;
+
+ChunkScheduler::ChunkScheduler(std::size_t threads, ChunkStore& store,
+                               WorldGenerator& generator)
+    : m_store(store), m_generator(generator)
+{
+	threads = threads == 0 ? 1 : threads;
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		m_threads.emplace_back(&ChunkScheduler::run, this);
+	}
+}
+
+ChunkScheduler::~ChunkScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	// jobs that haven't started are dropped, their futures are left
+	// holding a broken promise.
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+ChunkScheduler::Result ChunkScheduler::request(const ChunkPos& pos)
+{
+	std::shared_ptr<Job> job;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::shared_ptr<Job>& existing = m_jobs[pos];
+		if (existing != nullptr)
+		{
+			return existing->result;
+		}
+
+		existing         = std::make_shared<Job>();
+		existing->pos    = pos;
+		existing->result = existing->promise.get_future().share();
+
+		job = existing;
+		m_queue.push_back(job);
+	}
+
+	m_wake.notify_one();
+	return job->result;
+}
+
+ChunkSnapshot ChunkScheduler::take(const ChunkPos& pos)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	std::shared_ptr<Job>& existing = m_jobs[pos];
+	if (existing == nullptr)
+	{
+		existing         = std::make_shared<Job>();
+		existing->pos    = pos;
+		existing->result = existing->promise.get_future().share();
+	}
+
+	const std::shared_ptr<Job> job = existing;
+
+	// a job still in the queue is run here instead, the worker that pops
+	// it later just skips it.
+	const bool run = !job->started;
+	job->started   = true;
+	job->taken     = true;
+
+	lock.unlock();
+
+	if (run)
+	{
+		complete(job);
+	}
+
+	job->result.wait();
+
+	lock.lock();
+	forget(job);
+	lock.unlock();
+
+	// throws if the chunk couldn't be generated.
+	return job->result.get();
+}
+
+std::size_t ChunkScheduler::collect(std::vector<ChunkSnapshot>& finished,
+                                    std::vector<ChunkPos>*      failed)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::size_t count = 0;
+	for (const std::shared_ptr<Job>& job : m_finished)
+	{
+		if (job->taken)
+		{
+			continue;
+		}
+
+		forget(job);
+
+		try
+		{
+			finished.push_back(job->result.get());
+			++count;
+		}
+		catch (...)
+		{
+			// already logged by complete(), requesting the chunk again
+			// has another go at it.
+			if (failed != nullptr)
+			{
+				failed->push_back(job->pos);
+			}
+		}
+	}
+
+	m_finished.clear();
+	return count;
+}
+
+bool ChunkScheduler::isPending(const ChunkPos& pos)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_jobs.contains(pos);
+}
+
+std::size_t ChunkScheduler::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_jobs.size();
+}
+
+void ChunkScheduler::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+		if (m_stop)
+		{
+			return;
+		}
+
+		std::shared_ptr<Job> job = std::move(m_queue.front());
+		m_queue.pop_front();
+
+		// take() got to it first.
+		if (job->started)
+		{
+			continue;
+		}
+
+		job->started = true;
+
+		lock.unlock();
+		complete(job);
+		lock.lock();
+	}
+}
+
+void ChunkScheduler::complete(const std::shared_ptr<Job>& job)
+{
+	// the promise is kept whatever happens, anything waiting on the chunk
+	// would hang otherwise.
+	try
+	{
+		auto chunk = std::make_shared<Chunk>(job->pos);
+
+		// a payload that doesn't load leaves the chunk untouched, so it's
+		// generated as if it had never been saved.
+		bool loaded = false;
+		try
+		{
+			data::Data payload;
+			loaded = m_store.load(job->pos, payload) && chunk->load(payload);
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARNING("MAP") << "Chunk " << job->pos.x << ", " << job->pos.y
+			                   << ", " << job->pos.z
+			                   << " couldn't be loaded: " << e.what();
+
+			// it might have been loaded part way.
+			chunk = std::make_shared<Chunk>(job->pos);
+		}
+
+		if (!loaded)
+		{
+			m_generator.generate(*chunk);
+		}
+
+		job->promise.set_value(std::move(chunk));
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARNING("MAP") << "Chunk " << job->pos.x << ", " << job->pos.y
+		                   << ", " << job->pos.z
+		                   << " couldn't be generated: " << e.what();
+
+		job->promise.set_exception(std::current_exception());
+	}
+	catch (...)
+	{
+		LOG_WARNING("MAP") << "Chunk " << job->pos.x << ", " << job->pos.y
+		                   << ", " << job->pos.z
+		                   << " couldn't be generated: unknown error";
+
+		job->promise.set_exception(std::current_exception());
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_finished.push_back(job);
+}
+
+void ChunkScheduler::forget(const std::shared_ptr<Job>& job)
+{
+	const std::shared_ptr<Job>* current = m_jobs.find(job->pos);
+	if (current != nullptr && *current == job)
+	{
+		m_jobs.erase(job->pos);
+	}
+}
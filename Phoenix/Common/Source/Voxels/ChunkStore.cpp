@@ -0,0 +1,222 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Voxels/ChunkStore.hpp>
+
+#include <utility>
+
+using namespace phx::voxels;
+using namespace phx;
+
+ChunkStore::ChunkStore(std::string directory, std::string name)
+    : m_directory(std::move(directory)), m_name(std::move(name))
+{
+	m_thread = std::thread(&ChunkStore::run, this);
+}
+
+ChunkStore::~ChunkStore()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	// the thread drains whatever is pending before it exits.
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+bool ChunkStore::load(const ChunkPos& pos, data::Data& payload)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (const data::Data* pending = m_pending.find(pos))
+		{
+			payload = *pending;
+			return true;
+		}
+	}
+
+	// if the I/O thread has already taken the payload it's holding this
+	// until the payload is on disk, so this can't read stale data.
+	std::lock_guard<std::mutex> lock(m_regionMutex);
+
+	RegionFile& region = getRegion(pos);
+	if (!region.contains(pos))
+	{
+		return false;
+	}
+
+	if (!region.read(pos, payload))
+	{
+		LOG_WARNING("MAP") << "Chunk " << pos.x << ", " << pos.y << ", "
+		                   << pos.z << " is damaged and can't be loaded.";
+		return false;
+	}
+
+	return true;
+}
+
+bool ChunkStore::contains(const ChunkPos& pos)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_pending.contains(pos))
+		{
+			return true;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_regionMutex);
+	return getRegion(pos).contains(pos);
+}
+
+void ChunkStore::store(const ChunkPos& pos, data::Data payload)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending[pos] = std::move(payload);
+		++m_queuedCount;
+	}
+
+	m_wake.notify_one();
+}
+
+bool ChunkStore::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	const std::uint64_t target = m_queuedCount;
+	m_written.wait(lock, [this, target] { return m_writtenCount >= target; });
+
+	const bool succeeded = !m_failed;
+	m_failed             = false;
+
+	return succeeded;
+}
+
+std::size_t ChunkStore::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending.size();
+}
+
+void ChunkStore::run()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+
+			if (m_pending.empty())
+			{
+				return;
+			}
+		}
+
+		std::lock_guard<std::mutex> regionLock(m_regionMutex);
+
+		ChunkTable<data::Data> batch;
+		std::uint64_t          batchEnd;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::swap(batch, m_pending);
+			batchEnd = m_queuedCount;
+		}
+
+		bool succeeded = true;
+		batch.forEach([this, &succeeded](const ChunkPos& pos,
+		                                 const data::Data& payload) {
+			if (!getRegion(pos).write(pos, payload))
+			{
+				LOG_WARNING("MAP") << "Failed to save chunk " << pos.x << ", "
+				                   << pos.y << ", " << pos.z;
+				succeeded = false;
+			}
+		});
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_writtenCount = batchEnd;
+			m_failed       = m_failed || !succeeded;
+		}
+
+		m_written.notify_all();
+	}
+}
+
+RegionFile& ChunkStore::getRegion(const ChunkPos& pos)
+{
+	const ChunkPos regionPos = RegionFile::toRegionPos(pos);
+
+	if (OpenRegion* open = m_regions.find(regionPos))
+	{
+		open->lastUsed = ++m_regionUses;
+		return *open->file;
+	}
+
+	// every open region holds a file handle, so only a few stay open.
+	if (m_regions.size() >= MAX_OPEN_REGIONS)
+	{
+		closeOldestRegion();
+	}
+
+	// named after the position of the region.
+	const std::string path = m_directory + "/" + m_name + "." +
+	                         std::to_string(regionPos.x) + "_" +
+	                         std::to_string(regionPos.y) + "_" +
+	                         std::to_string(regionPos.z) + ".region";
+
+	OpenRegion& region = m_regions[regionPos];
+	region.file        = std::make_unique<RegionFile>(path);
+	region.lastUsed    = ++m_regionUses;
+	if (!region.file->isValid())
+	{
+		LOG_WARNING("MAP") << "Unable to use region file: " << path;
+	}
+
+	return *region.file;
+}
+
+void ChunkStore::closeOldestRegion()
+{
+	ChunkPos      oldest;
+	std::uint64_t lastUsed = ~std::uint64_t(0);
+	m_regions.forEach([&](const ChunkPos& pos, const OpenRegion& region) {
+		if (region.lastUsed < lastUsed)
+		{
+			oldest   = pos;
+			lastUsed = region.lastUsed;
+		}
+	});
+
+	// every write is flushed as it's made, so the file can just be closed.
+	m_regions.erase(oldest);
+}
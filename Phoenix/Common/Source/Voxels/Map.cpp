@@ -26,105 +26,428 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <Common/Logger.hpp>
+#include <Common/Settings.hpp>
 #include <Common/Voxels/Map.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <utility>
 
 using namespace phx::voxels;
+using namespace phx;
 
 Map::Map(const std::string& save, const std::string& name)
-    : m_save(save), m_mapName(name)
+    : m_store(std::make_unique<ChunkStore>("Saves/" + save, name)),
+      m_lastSave(Clock::now()), m_save(save), m_mapName(name)
+{
+	m_saveInterval =
+	    Settings::get()->add("Save Interval (ms)", "map:saveInterval", 5000);
+	m_saveInterval->setMin(0);
+	m_saveInterval->setMax(60000);
+
+	importLegacySaves();
+
+	// half of the cores the main thread leaves, the rest are for meshing.
+	const int cores   = static_cast<int>(std::thread::hardware_concurrency());
+	const int threads = std::max(1, (cores - 1) / 2);
+
+	Setting* generationThreads = Settings::get()->add(
+	    "Generation Threads", "map:generationThreads", threads);
+	generationThreads->setMin(1);
+	generationThreads->setMax(64);
+
+	m_generator = std::make_unique<WorldGenerator>(loadSeed(m_save, m_mapName));
+	m_scheduler = std::make_unique<ChunkScheduler>(
+	    static_cast<std::size_t>(generationThreads->value()), *m_store,
+	    *m_generator);
+}
+
+Map::~Map()
+{
+	// a moved from map has nothing left to save.
+	if (m_store != nullptr)
+	{
+		// the workers stop before anything they use is destroyed.
+		m_scheduler.reset();
+		flush();
+	}
+}
+
+Chunk& Map::getChunk(const ChunkPos& pos)
+{
+	if (std::unique_ptr<Chunk>* chunk = m_chunks.find(pos))
+	{
+		return **chunk;
+	}
+
+	// generation always gives the same result, so there's no need to save
+	// a generated chunk until it's edited. the copy shares the snapshot's
+	// blocks, which is fine as it's the only other owner. take() can
+	// throw, so the chunk is only added to the table once it exists.
+	auto   chunk  = std::make_unique<Chunk>(*m_scheduler->take(pos));
+	Chunk& loaded = *chunk;
+
+	m_chunks[pos] = std::move(chunk);
+	return loaded;
+}
+
+ChunkScheduler::Result Map::requestChunk(const ChunkPos& pos)
+{
+	if (m_chunks.contains(pos))
+	{
+		std::promise<ChunkSnapshot> resident;
+		resident.set_value(getSnapshot(pos));
+		return resident.get_future().share();
+	}
+
+	return m_scheduler->request(pos);
+}
+
+Chunk* Map::findChunk(const ChunkPos& pos)
+{
+	std::unique_ptr<Chunk>* chunk = m_chunks.find(pos);
+	return chunk == nullptr ? nullptr : chunk->get();
+}
+
+const Chunk* Map::findChunk(const ChunkPos& pos) const
+{
+	const std::unique_ptr<Chunk>* chunk = m_chunks.find(pos);
+	return chunk == nullptr ? nullptr : chunk->get();
+}
+
+ChunkSnapshot Map::getSnapshot(const ChunkPos& pos) const
+{
+	const Chunk* chunk = findChunk(pos);
+	return chunk == nullptr ? nullptr : std::make_shared<const Chunk>(*chunk);
+}
+
+void Map::setBlockAt(const BlockPos& position, BlockType* block)
 {
+	const ChunkPos chunkPosition = toChunkPos(position);
+
+	getChunk(chunkPosition).setBlockAt(toLocalPos(position), block);
+
+	// saved on the first tick after the interval, so a burst of edits to
+	// the same chunk is only written once.
+	m_dirty[chunkPosition] = true;
+}
+
+bool Map::fill(const BlockPos& min, const BlockPos& max, BlockType* block)
+{
+	if (!isUsableBox(min, max))
+	{
+		return false;
+	}
+
+	BlockPos low  = min;
+	BlockPos high = max;
+	sortCorners(low, high);
+
+	forEachChunk(low, high, true,
+	             [&](Chunk& chunk) { chunk.fill(low, high, block); });
+
+	return true;
 }
 
-Chunk Map::getChunk(const phx::math::vec3& pos)
+std::optional<BlockRegion> Map::read(const BlockPos& min, const BlockPos& max)
 {
-	if (m_chunks.find(pos) != m_chunks.end())
+	if (!isUsableBox(min, max))
 	{
-		return m_chunks.at(pos);
+		return std::nullopt;
 	}
-	else
+
+	std::optional<BlockRegion> region(std::in_place, min, max);
+	forEachChunk(region->getMin(), region->getMax(), false,
+	             [&region](Chunk& chunk) { chunk.read(*region); });
+
+	return region;
+}
+
+bool Map::write(const BlockRegion& region, const BlockPos& origin)
+{
+	// the origin is checked before anything is added to it, so a far off
+	// origin can't overflow.
+	if (!isInWorld(origin) ||
+	    !isUsableBox(origin, origin + region.getSize() - 1))
 	{
-		std::ifstream saveFile;
-		std::string   position = "." + std::to_string(int(pos.x)) + "_" +
-		                       std::to_string(int(pos.y)) + "_" +
-		                       std::to_string(int(pos.z));
-		saveFile.open("Saves/" + m_save + "/" + m_mapName + position + ".save");
+		return false;
+	}
 
-		if (saveFile)
+	forEachChunk(origin, origin + region.getSize() - 1, true,
+	             [&](Chunk& chunk) { chunk.write(region, origin); });
+
+	return true;
+}
+
+bool Map::isUsableBox(const BlockPos& min, const BlockPos& max)
+{
+	if (!isInWorld(min) || !isInWorld(max))
+	{
+		return false;
+	}
+
+	// widened before subtracting, the corners can be on opposite ends of
+	// the world. The volume is checked as it grows, so it can't overflow
+	// either.
+	const long long spans[] = {
+	    std::llabs(static_cast<long long>(max.x) - min.x) + 1,
+	    std::llabs(static_cast<long long>(max.y) - min.y) + 1,
+	    std::llabs(static_cast<long long>(max.z) - min.z) + 1};
+
+	long long volume = 1;
+	for (long long span : spans)
+	{
+		volume *= span;
+		if (volume > MAX_REGION_VOLUME)
 		{
-			std::string saveString;
-			std::getline(saveFile, saveString);
-			auto win = m_chunks.emplace(pos, Chunk(pos, saveString));
+			return false;
 		}
-		else
+	}
+
+	return true;
+}
+
+std::size_t Map::unloadChunks(
+    const std::function<bool(const ChunkPos&)>& shouldUnload)
+{
+	// the table can't change while it's being iterated.
+	std::vector<ChunkPos> unloading;
+	m_chunks.forEach([&](const ChunkPos& pos, std::unique_ptr<Chunk>&) {
+		if (shouldUnload(pos))
+		{
+			unloading.push_back(pos);
+		}
+	});
+
+	for (const ChunkPos& pos : unloading)
+	{
+		if (m_dirty.erase(pos))
 		{
-			auto win = m_chunks.emplace(pos, Chunk(pos));
-			m_chunks.at(pos).autoTestFill();
-			save(pos);
+			Chunk* chunk = findChunk(pos);
+			chunk->compact();
+			m_store->store(pos, chunk->save());
 		}
-		return m_chunks.at(pos);
+
+		m_chunks.erase(pos);
 	}
+
+	return unloading.size();
+}
+
+std::size_t Map::getMemoryUsage() const
+{
+	std::size_t bytes = 0;
+	m_chunks.forEach(
+	    [&bytes](const ChunkPos&, const std::unique_ptr<Chunk>& chunk) {
+		    bytes += chunk->getBlocks().getMemoryUsage();
+	    });
+
+	return bytes;
+}
+
+void Map::save(const ChunkPos& pos)
+{
+	Chunk& chunk = getChunk(pos);
+	chunk.compact();
+
+	m_store->store(pos, chunk.save());
+	m_dirty.erase(pos);
 }
 
-void Map::setBlockAt(phx::math::vec3 position, BlockType* block)
+void Map::tick()
 {
-	int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
-	int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
-	int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+	adoptFinished();
 
-	position.x =
-	    static_cast<float>(static_cast<int>(position.x) % Chunk::CHUNK_WIDTH);
-	if (position.x < 0)
+	const auto interval = std::chrono::milliseconds(m_saveInterval->value());
+	if (m_dirty.empty() || Clock::now() - m_lastSave < interval)
 	{
-		posX -= 1;
-		position.x += Chunk::CHUNK_WIDTH;
+		return;
 	}
 
-	position.y =
-	    static_cast<float>(static_cast<int>(position.y) % Chunk::CHUNK_HEIGHT);
-	if (position.y < 0)
+	saveDirty();
+}
+
+bool Map::flush()
+{
+	saveDirty();
+	return m_store->flush();
+}
+
+std::size_t Map::importLegacySaves()
+{
+	namespace fs = std::filesystem;
+
+	const fs::path  directory = "Saves/" + m_save;
+	std::error_code error;
+
+	// collect the files first, renaming while iterating isn't safe.
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry :
+	     fs::directory_iterator(directory, error))
 	{
-		posY -= 1;
-		position.y += Chunk::CHUNK_HEIGHT;
+		const fs::path& path = entry.path();
+		if (path.extension() == ".save" &&
+		    path.stem().string().rfind(m_mapName + ".", 0) == 0)
+		{
+			files.push_back(path);
+		}
 	}
 
-	position.z =
-	    static_cast<float>(static_cast<int>(position.z) % Chunk::CHUNK_DEPTH);
-	if (position.z < 0)
+	std::vector<fs::path> imported;
+	for (const fs::path& path : files)
 	{
-		posZ -= 1;
-		position.z += Chunk::CHUNK_DEPTH;
+		// the stem is "<name>.<x>_<y>_<z>", the position of the first block.
+		const std::string position =
+		    path.stem().string().substr(m_mapName.size() + 1);
+
+		BlockPos           origin;
+		char               separator[2];
+		std::istringstream stream(position);
+		stream >> origin.x >> separator[0] >> origin.y >> separator[1] >>
+		    origin.z;
+
+		if (!stream || separator[0] != '_' || separator[1] != '_')
+		{
+			LOG_WARNING("MAP") << "Skipping unrecognised save file: "
+			                   << path.string();
+			continue;
+		}
+
+		std::ifstream file(path);
+		std::string   saveString;
+		std::getline(file, saveString);
+
+		const ChunkPos pos = toChunkPos(origin);
+		Chunk          chunk(pos, saveString);
+		m_store->store(pos, chunk.save());
+
+		imported.push_back(path);
 	}
 
-	const math::vec3 chunkPosition =
-	    math::vec3(static_cast<float>(posX * Chunk::CHUNK_WIDTH),
-	               static_cast<float>(posY * Chunk::CHUNK_HEIGHT),
-	               static_cast<float>(posZ * Chunk::CHUNK_DEPTH));
+	// only rename the old files once their chunks are definitely on disk,
+	// so an interrupted import is just done again next time.
+	if (imported.empty() || !m_store->flush())
+	{
+		return 0;
+	}
+
+	for (const fs::path& path : imported)
+	{
+		fs::rename(path, path.string() + ".imported", error);
+	}
 
-	m_chunks.at(chunkPosition)
-	    .setBlockAt(
-	        {
-	            // "INLINE" VECTOR 3 DECLARATION
-	            position.x, // x position IN the chunk, not overall
-	            position.y, // y position IN the chunk, not overall
-	            position.z  // z position IN the chunk, not overall
-	        },
-	        block);
+	LOG_INFO("MAP") << "Imported " << imported.size() << " chunks from \""
+	                << directory.string() << "\" into region files.";
 
-	save(chunkPosition);
+	return imported.size();
 }
 
-void Map::save(const phx::math::vec3& pos)
+void Map::saveDirty()
 {
-	std::ofstream saveFile;
-	std::string   position = "." + std::to_string(int(pos.x)) + "_" +
-	                       std::to_string(int(pos.y)) + "_" +
-	                       std::to_string(int(pos.z));
-	saveFile.open("Saves/" + m_save + "/" + m_mapName + position + ".save");
-	saveFile << m_chunks.at(pos).save();
+	m_dirty.forEach([this](const ChunkPos& pos, bool) {
+		Chunk& chunk = getChunk(pos);
+		chunk.compact();
 
-	saveFile.close();
+		m_store->store(pos, chunk.save());
+	});
+
+	m_dirty.clear();
+	m_lastSave = Clock::now();
 }
 
+void Map::adoptFinished()
+{
+	std::vector<ChunkSnapshot> finished;
+	m_scheduler->collect(finished);
+
+	for (const ChunkSnapshot& snapshot : finished)
+	{
+		const ChunkPos pos = snapshot->getChunkPos();
+		if (!m_chunks.contains(pos))
+		{
+			m_chunks[pos] = std::make_unique<Chunk>(*snapshot);
+		}
+	}
+}
+
+void Map::forEachChunk(const BlockPos& min, const BlockPos& max, bool edit,
+                       const std::function<void(Chunk&)>& function)
+{
+	const ChunkPos first = toChunkPos(min);
+	const ChunkPos last  = toChunkPos(max);
+
+	// everything missing is requested up front, so the workers load it in
+	// parallel while the chunks are worked through in order.
+	for (int z = first.z; z <= last.z; ++z)
+	{
+		for (int y = first.y; y <= last.y; ++y)
+		{
+			for (int x = first.x; x <= last.x; ++x)
+			{
+				if (!m_chunks.contains(ChunkPos(x, y, z)))
+				{
+					m_scheduler->request(ChunkPos(x, y, z));
+				}
+			}
+		}
+	}
+
+	for (int z = first.z; z <= last.z; ++z)
+	{
+		for (int y = first.y; y <= last.y; ++y)
+		{
+			for (int x = first.x; x <= last.x; ++x)
+			{
+				const ChunkPos pos(x, y, z);
+				function(getChunk(pos));
+
+				if (edit)
+				{
+					m_dirty[pos] = true;
+				}
+			}
+		}
+	}
+}
+
+std::uint32_t Map::loadSeed(const std::string& save, const std::string& name)
+{
+	namespace fs = std::filesystem;
+
+	const fs::path  directory = "Saves/" + save;
+	const fs::path  path      = directory / (name + ".seed");
+	std::error_code error;
+
+	std::uint32_t seed = 0;
+	std::ifstream in(path);
+	if (in >> seed)
+	{
+		return seed;
+	}
+
+	if (fs::exists(path, error))
+	{
+		LOG_WARNING("MAP") << "Unreadable seed in \"" << path.string()
+		                   << "\", picking a new one.";
+	}
+
+	seed = std::random_device()();
+
+	fs::create_directories(directory, error);
+	std::ofstream out(path);
+	out << seed << '\n';
+
+	if (!out)
+	{
+		LOG_WARNING("MAP") << "Couldn't save the seed to \"" << path.string()
+		                   << "\", the terrain will change next time.";
+	}
+
+	return seed;
+}
@@ -0,0 +1,426 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Serialization/BinaryIO.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+using namespace phx::voxels;
+using namespace phx;
+
+static constexpr char        REGION_MAGIC[4] = {'P', 'H', 'X', 'R'};
+static constexpr std::size_t ENTRY_SIZE      = 3 * sizeof(std::uint32_t);
+static constexpr std::size_t TABLE_OFFSET =
+    sizeof(REGION_MAGIC) + 2 * sizeof(std::uint32_t);
+
+// version 1 tables had no crc.
+static constexpr std::size_t V1_ENTRY_SIZE = 2 * sizeof(std::uint32_t);
+
+// compacting a file rewrites all of it, so it's not worth doing for the odd
+// replaced payload.
+static constexpr std::uint32_t MIN_COMPACT_WASTE = 1 << 20;
+
+static constexpr std::size_t getHeaderSize(std::size_t entrySize)
+{
+	return TABLE_OFFSET + RegionFile::CHUNKS_PER_REGION * entrySize;
+}
+
+// the same CRC-32 as zlib, so payloads can be checked with other tools.
+static std::uint32_t crc32(const data::Data& data)
+{
+	static const std::array<std::uint32_t, 256> table = [] {
+		std::array<std::uint32_t, 256> crcs {};
+		for (std::uint32_t i = 0; i < crcs.size(); ++i)
+		{
+			std::uint32_t crc = i;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0xEDB88320u : 0u);
+			}
+
+			crcs[i] = crc;
+		}
+
+		return crcs;
+	}();
+
+	std::uint32_t crc = ~0u;
+	for (std::byte byte : data)
+	{
+		crc = table[(crc ^ std::to_integer<std::uint32_t>(byte)) & 0xFF] ^
+		      (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+RegionFile::RegionFile(const std::string& path) : m_path(path)
+{
+	m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+	if (m_file)
+	{
+		m_valid = readHeader();
+		return;
+	}
+
+	// the file doesn't exist yet, so write an empty header - opening with
+	// std::ios::in fails if there's no file to open.
+	const data::Data header = makeHeader({});
+
+	{
+		std::ofstream create(path, std::ios::binary);
+		create.write(reinterpret_cast<const char*>(header.data()),
+		             header.size());
+		if (!create)
+		{
+			return;
+		}
+	}
+
+	m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+	m_end   = static_cast<std::uint32_t>(header.size());
+	m_valid = static_cast<bool>(m_file);
+}
+
+bool RegionFile::contains(const ChunkPos& pos) const
+{
+	return m_valid && m_table[indexOf(pos)].offset != 0;
+}
+
+bool RegionFile::read(const ChunkPos& pos, data::Data& payload)
+{
+	if (!contains(pos))
+	{
+		return false;
+	}
+
+	const Entry& entry = m_table[indexOf(pos)];
+
+	payload.resize(entry.length);
+
+	m_file.clear();
+	m_file.seekg(entry.offset);
+	m_file.read(reinterpret_cast<char*>(payload.data()), entry.length);
+
+	if (!m_file)
+	{
+		return false;
+	}
+
+	return m_version < 2 || crc32(payload) == entry.crc;
+}
+
+bool RegionFile::write(const ChunkPos& pos, const data::Data& payload)
+{
+	if (!m_valid || payload.empty())
+	{
+		return false;
+	}
+
+	constexpr std::uint32_t maxEnd = std::numeric_limits<std::uint32_t>::max();
+	if (payload.size() > maxEnd - m_end)
+	{
+		// most of the file might be replaced payloads, which compacting
+		// frees up.
+		if (m_wasted == 0 || !compact() || payload.size() > maxEnd - m_end)
+		{
+			return false;
+		}
+	}
+
+	// always appended, never written over the old payload - that stays
+	// intact until the table stops pointing at it.
+	Entry entry;
+	entry.offset = m_end;
+	entry.length = static_cast<std::uint32_t>(payload.size());
+	entry.crc    = crc32(payload);
+
+	m_file.clear();
+	m_file.seekp(entry.offset);
+	m_file.write(reinterpret_cast<const char*>(payload.data()),
+	             payload.size());
+	m_file.flush();
+
+	if (!m_file)
+	{
+		return false;
+	}
+
+	m_end += entry.length;
+
+	const std::size_t index = indexOf(pos);
+	if (m_table[index].offset != 0)
+	{
+		m_wasted += m_table[index].length;
+	}
+
+	m_table[index] = entry;
+	writeEntry(index);
+
+	m_file.flush();
+	if (!m_file)
+	{
+		return false;
+	}
+
+	// only once the table points at the new payload, so the compacted file
+	// holds it too.
+	if (m_wasted >= MIN_COMPACT_WASTE && m_wasted >= m_end / 2)
+	{
+		compact();
+	}
+
+	return true;
+}
+
+bool RegionFile::compact()
+{
+	if (!m_valid)
+	{
+		return false;
+	}
+
+	const std::string compacted = m_path + ".compact";
+
+	std::array<Entry, CHUNKS_PER_REGION> table;
+	std::uint32_t end = static_cast<std::uint32_t>(getHeaderSize(ENTRY_SIZE));
+
+	bool written = false;
+	{
+		std::ofstream out(compacted, std::ios::binary | std::ios::trunc);
+
+		// a placeholder until the new table is known.
+		const data::Data empty = makeHeader({});
+		out.write(reinterpret_cast<const char*>(empty.data()), empty.size());
+
+		// the live payloads are packed one after another, in table order.
+		data::Data payload;
+		for (std::size_t i = 0; out && i < CHUNKS_PER_REGION; ++i)
+		{
+			const Entry& entry = m_table[i];
+			if (entry.offset == 0)
+			{
+				continue;
+			}
+
+			payload.resize(entry.length);
+
+			m_file.clear();
+			m_file.seekg(entry.offset);
+			m_file.read(reinterpret_cast<char*>(payload.data()), entry.length);
+			if (!m_file)
+			{
+				out.setstate(std::ios::failbit);
+				break;
+			}
+
+			// payloads are copied as they are, one that doesn't match its
+			// CRC still won't be read. Version 1 ones get their CRC now.
+			table[i] = {end, entry.length,
+			            m_version >= 2 ? entry.crc : crc32(payload)};
+
+			out.write(reinterpret_cast<const char*>(payload.data()),
+			          payload.size());
+			end += entry.length;
+		}
+
+		const data::Data header = makeHeader(table);
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(header.data()), header.size());
+		out.flush();
+
+		written = static_cast<bool>(out);
+	}
+
+	std::error_code error;
+	if (!written)
+	{
+		std::filesystem::remove(compacted, error);
+		return false;
+	}
+
+	// Windows won't replace a file that's still open.
+	m_file.close();
+	std::filesystem::rename(compacted, m_path, error);
+	m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+
+	if (error)
+	{
+		// the old file is untouched, carry on with it.
+		std::filesystem::remove(compacted, error);
+		m_valid = static_cast<bool>(m_file);
+		return false;
+	}
+
+	m_table   = table;
+	m_version = VERSION;
+	m_end     = end;
+	m_wasted  = 0;
+	m_valid   = static_cast<bool>(m_file);
+
+	return m_valid;
+}
+
+std::size_t RegionFile::indexOf(const ChunkPos& pos)
+{
+	constexpr int mask = REGION_SIZE - 1;
+
+	return static_cast<std::size_t>(pos.x & mask) |
+	       (static_cast<std::size_t>(pos.y & mask) << REGION_SHIFT) |
+	       (static_cast<std::size_t>(pos.z & mask) << (REGION_SHIFT * 2));
+}
+
+data::Data RegionFile::makeHeader(
+    const std::array<Entry, CHUNKS_PER_REGION>& table)
+{
+	data::BinaryWriter header;
+	header.reserve(getHeaderSize(ENTRY_SIZE));
+	for (char c : REGION_MAGIC)
+	{
+		header.write(c);
+	}
+	header.write(VERSION);
+	header.write(static_cast<std::uint32_t>(CHUNKS_PER_REGION));
+
+	for (const Entry& entry : table)
+	{
+		header.write(entry.offset);
+		header.write(entry.length);
+		header.write(entry.crc);
+	}
+
+	return std::move(header.getBuffer());
+}
+
+bool RegionFile::readHeader()
+{
+	m_file.seekg(0, std::ios::end);
+	const std::streamoff fileSize = m_file.tellg();
+	m_file.seekg(0);
+
+	if (fileSize < static_cast<std::streamoff>(TABLE_OFFSET) ||
+	    fileSize > std::numeric_limits<std::uint32_t>::max())
+	{
+		return false;
+	}
+
+	data::Data header(TABLE_OFFSET);
+	m_file.read(reinterpret_cast<char*>(header.data()), TABLE_OFFSET);
+	if (!m_file ||
+	    std::memcmp(header.data(), REGION_MAGIC, sizeof(REGION_MAGIC)) != 0)
+	{
+		return false;
+	}
+
+	data::BinaryReader reader(header);
+	for (char c : REGION_MAGIC)
+	{
+		reader.read(c);
+	}
+
+	std::uint32_t chunks = 0;
+	reader.read(m_version);
+	reader.read(chunks);
+
+	// refuse newer versions rather than risk overwriting data we don't
+	// understand.
+	if (m_version == 0 || m_version > VERSION || chunks != CHUNKS_PER_REGION)
+	{
+		return false;
+	}
+
+	const std::size_t headerSize = getHeaderSize(getEntrySize());
+	if (fileSize < static_cast<std::streamoff>(headerSize))
+	{
+		return false;
+	}
+
+	data::Data table(headerSize - TABLE_OFFSET);
+	m_file.read(reinterpret_cast<char*>(table.data()), table.size());
+	if (!m_file)
+	{
+		return false;
+	}
+
+	m_end = static_cast<std::uint32_t>(fileSize);
+
+	// whatever isn't the header or a live payload was left behind by
+	// payloads that have been replaced.
+	std::uint64_t used = headerSize;
+
+	data::BinaryReader entries(table);
+	for (Entry& entry : m_table)
+	{
+		entries.read(entry.offset);
+		entries.read(entry.length);
+		if (m_version >= 2)
+		{
+			entries.read(entry.crc);
+		}
+
+		// a truncated file leaves entries pointing past the end, treat
+		// those chunks as never saved.
+		if (entry.offset < headerSize || entry.offset > m_end ||
+		    entry.length == 0 || entry.length > m_end - entry.offset)
+		{
+			entry = {};
+		}
+
+		used += entry.length;
+	}
+
+	m_wasted = used < m_end ? m_end - static_cast<std::uint32_t>(used) : 0;
+
+	return reader.good() && entries.good();
+}
+
+void RegionFile::writeEntry(std::size_t index)
+{
+	data::BinaryWriter writer;
+	writer.write(m_table[index].offset);
+	writer.write(m_table[index].length);
+	if (m_version >= 2)
+	{
+		writer.write(m_table[index].crc);
+	}
+
+	m_file.seekp(TABLE_OFFSET + index * getEntrySize());
+	m_file.write(reinterpret_cast<const char*>(writer.getBuffer().data()),
+	             getEntrySize());
+}
+
+std::size_t RegionFile::getEntrySize() const
+{
+	return m_version >= 2 ? ENTRY_SIZE : V1_ENTRY_SIZE;
+}
@@ -30,13 +30,15 @@
 
 using namespace phx::voxels;
 
-void TextureRegistry::addTexture(const std::string& texture)
+std::size_t TextureRegistry::addTexture(const std::string& texture)
 {
-	m_textures.insert(texture);
-}
+	const auto it = m_indices.emplace(texture, m_textures.size());
+	if (it.second)
+	{
+		m_textures.push_back(texture);
+	}
 
-std::vector<std::string> TextureRegistry::getTextures()
-{
-	return {m_textures.begin(), m_textures.end()};
+	return it.first->second;
 }
 
+std::vector<std::string> TextureRegistry::getTextures() { return m_textures; }
@@ -0,0 +1,356 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockRegistry.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace phx::voxels;
+using namespace phx;
+
+namespace
+{
+	// the ground is at BASE_HEIGHT on average, and can be up to
+	// HEIGHT_RANGE above or below it.
+	constexpr float BASE_HEIGHT      = 8.f;
+	constexpr float HEIGHT_RANGE     = 32.f;
+	constexpr float HEIGHT_FREQUENCY = 1.f / 256.f;
+	constexpr int   HEIGHT_OCTAVES   = 4;
+	constexpr float SOIL_FREQUENCY   = 1.f / 32.f;
+	constexpr int   MIN_SOIL_DEPTH   = 2;
+	constexpr int   MAX_SOIL_DEPTH   = 5;
+	constexpr float CAVE_FREQUENCY   = 1.f / 32.f;
+	constexpr float CAVE_THICKNESS   = 0.08f;
+
+	// each octave is shifted so their lattices don't line up.
+	constexpr float OCTAVE_OFFSET = 1013.f;
+
+	constexpr int CHUNK_VOLUME =
+	    Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT * Chunk::CHUNK_DEPTH;
+
+	// gives every stage its own seed, so their noise isn't correlated.
+	std::uint32_t stageSeed(std::uint32_t seed, std::uint32_t stage)
+	{
+		std::uint32_t h = seed + stage * 0x9e3779b9u;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h;
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	// adds the time since a point to a counter, returning the time now.
+	Clock::time_point addElapsed(std::atomic<std::uint64_t>& counter,
+	                             Clock::time_point since)
+	{
+		const Clock::time_point now = Clock::now();
+		counter += static_cast<std::uint64_t>(
+		    std::chrono::duration_cast<std::chrono::nanoseconds>(now - since)
+		        .count());
+		return now;
+	}
+
+	// looks a block up, falling back to another if it isn't registered.
+	std::size_t findBlock(const std::string& id, std::size_t fallback)
+	{
+		const std::size_t found =
+		    BlockRegistry::get()->getFromID(id)->getRegistryID();
+		return found == BlockRegistry::UNKNOWN_BLOCK ? fallback : found;
+	}
+} // namespace
+
+WorldGenerator::WorldGenerator(std::uint32_t seed)
+    : m_seed(seed), m_heightNoise(stageSeed(seed, 0)),
+      m_soilNoise(stageSeed(seed, 1)), m_caveNoise(stageSeed(seed, 2)),
+      m_tunnelNoise(stageSeed(seed, 3))
+{
+	m_air   = findBlock("core.air", BlockRegistry::UNKNOWN_BLOCK);
+	m_grass = findBlock("core.grass", BlockRegistry::UNKNOWN_BLOCK);
+	m_dirt  = findBlock("core.dirt", m_grass);
+	m_stone = findBlock("core.stone", m_dirt);
+}
+
+void WorldGenerator::generate(Chunk& chunk)
+{
+	const ChunkPos pos = chunk.getChunkPos();
+
+	Clock::time_point time = Clock::now();
+
+	const std::shared_ptr<const Column> column = getColumn(pos.x, pos.z);
+	time = addElapsed(m_heightmapTime, time);
+
+	++m_chunkCount;
+
+	// nothing but air, which the chunk already is.
+	if (pos.y * Chunk::CHUNK_HEIGHT > column->highest)
+	{
+		++m_emptyCount;
+		return;
+	}
+
+	fillGround(chunk, *column);
+	time = addElapsed(m_surfaceTime, time);
+
+	carveCaves(chunk, *column);
+	addElapsed(m_caveTime, time);
+}
+
+int WorldGenerator::getHeightAt(int x, int z)
+{
+	const ChunkPos chunk = toChunkPos(BlockPos(x, 0, z));
+	const BlockPos local = toLocalPos(BlockPos(x, 0, z));
+
+	return getColumn(chunk.x, chunk.z)
+	    ->height[local.x + Chunk::CHUNK_WIDTH * local.z];
+}
+
+WorldGeneratorStats WorldGenerator::getStats() const
+{
+	using std::chrono::nanoseconds;
+
+	WorldGeneratorStats stats;
+	stats.chunks      = m_chunkCount;
+	stats.emptyChunks = m_emptyCount;
+	stats.columns     = m_columnCount;
+	stats.heightmap   = nanoseconds(m_heightmapTime);
+	stats.surface     = nanoseconds(m_surfaceTime);
+	stats.caves       = nanoseconds(m_caveTime);
+
+	return stats;
+}
+
+std::shared_ptr<const WorldGenerator::Column> WorldGenerator::getColumn(
+    int x, int z)
+{
+	const ChunkPos key(x, 0, z);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (const std::shared_ptr<const Column>* column = m_columns.find(key))
+		{
+			return *column;
+		}
+	}
+
+	// built without the lock so other threads aren't held up, if two
+	// threads build the same column they get identical results anyway.
+	std::shared_ptr<const Column> built = buildColumn(x, z);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::shared_ptr<const Column>& cached = m_columns[key];
+	if (cached != nullptr)
+	{
+		return cached;
+	}
+
+	cached = built;
+	m_columnOrder.push_back(key);
+	++m_columnCount;
+
+	while (m_columnOrder.size() > MAX_CACHED_COLUMNS)
+	{
+		m_columns.erase(m_columnOrder.front());
+		m_columnOrder.pop_front();
+	}
+
+	return built;
+}
+
+std::unique_ptr<WorldGenerator::Column> WorldGenerator::buildColumn(
+    int x, int z) const
+{
+	const float originX = static_cast<float>(x * Chunk::CHUNK_WIDTH);
+	const float originZ = static_cast<float>(z * Chunk::CHUNK_DEPTH);
+
+	std::array<float, COLUMN_AREA> height {};
+	std::array<float, COLUMN_AREA> octave;
+
+	// each octave has twice the frequency and half the amplitude of the
+	// last, the amplitudes add up to just under 1.
+	float frequency = HEIGHT_FREQUENCY;
+	float amplitude = 0.5f;
+	for (int o = 0; o < HEIGHT_OCTAVES; ++o)
+	{
+		const float offset = OCTAVE_OFFSET * static_cast<float>(o);
+		m_heightNoise.fill2D(octave.data(), originX + offset, originZ + offset,
+		                     Chunk::CHUNK_WIDTH, Chunk::CHUNK_DEPTH,
+		                     frequency);
+
+		for (int i = 0; i < COLUMN_AREA; ++i)
+		{
+			height[i] += octave[i] * amplitude;
+		}
+
+		frequency *= 2.f;
+		amplitude *= 0.5f;
+	}
+
+	std::array<float, COLUMN_AREA> soil;
+	m_soilNoise.fill2D(soil.data(), originX, originZ, Chunk::CHUNK_WIDTH,
+	                   Chunk::CHUNK_DEPTH, SOIL_FREQUENCY);
+
+	auto column     = std::make_unique<Column>();
+	column->lowest  = std::numeric_limits<int>::max();
+	column->highest = std::numeric_limits<int>::min();
+
+	for (int i = 0; i < COLUMN_AREA; ++i)
+	{
+		const int ground = static_cast<int>(
+		    std::floor(BASE_HEIGHT + height[i] * HEIGHT_RANGE));
+
+		// noise is within [-1, 1], so this lands on [MIN, MAX].
+		const float depth =
+		    MIN_SOIL_DEPTH + (soil[i] + 1.f) * 0.5f *
+		                         (MAX_SOIL_DEPTH - MIN_SOIL_DEPTH + 1);
+
+		column->height[i]    = ground;
+		column->soilDepth[i] = static_cast<std::uint8_t>(std::clamp(
+		    static_cast<int>(depth), MIN_SOIL_DEPTH, MAX_SOIL_DEPTH));
+
+		column->lowest  = std::min(column->lowest, ground);
+		column->highest = std::max(column->highest, ground);
+	}
+
+	return column;
+}
+
+void WorldGenerator::fillGround(Chunk& chunk, const Column& column) const
+{
+	BlockRegistry* registry = BlockRegistry::get();
+
+	BlockType* grass = registry->getFromRegistryID(m_grass);
+	BlockType* dirt  = registry->getFromRegistryID(m_dirt);
+	BlockType* stone = registry->getFromRegistryID(m_stone);
+
+	const ChunkPos pos    = chunk.getChunkPos();
+	const int      bottom = pos.y * Chunk::CHUNK_HEIGHT;
+
+	// no column's soil reaches deeper than this, so a chunk that tops out
+	// below it is solid stone and can be filled in one go.
+	if (bottom + Chunk::CHUNK_HEIGHT - 1 <= column.lowest - MAX_SOIL_DEPTH)
+	{
+		const BlockPos min = toBlockPos(pos);
+		chunk.fill(min,
+		           min + BlockPos(Chunk::CHUNK_WIDTH - 1,
+		                          Chunk::CHUNK_HEIGHT - 1,
+		                          Chunk::CHUNK_DEPTH - 1),
+		           stone);
+		return;
+	}
+
+	for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+	{
+		for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+		{
+			const int i      = x + Chunk::CHUNK_WIDTH * z;
+			const int ground = column.height[i];
+			const int soil   = ground - column.soilDepth[i];
+
+			const int top = std::min(ground - bottom, Chunk::CHUNK_HEIGHT - 1);
+			for (int y = 0; y <= top; ++y)
+			{
+				const int worldY = bottom + y;
+
+				BlockType* block = stone;
+				if (worldY == ground)
+				{
+					block = grass;
+				}
+				else if (worldY > soil)
+				{
+					block = dirt;
+				}
+
+				chunk.setBlockAt(BlockPos(x, y, z), block);
+			}
+		}
+	}
+}
+
+void WorldGenerator::carveCaves(Chunk& chunk, const Column& column) const
+{
+	const ChunkPos pos    = chunk.getChunkPos();
+	const int      bottom = pos.y * Chunk::CHUNK_HEIGHT;
+
+	// caves stay under the soil, so the surface is never holed.
+	if (bottom > column.highest - MIN_SOIL_DEPTH)
+	{
+		return;
+	}
+
+	// both fields are sampled for the whole chunk at once, in the same
+	// order as the chunk's blocks.
+	std::vector<float> cave(CHUNK_VOLUME);
+	std::vector<float> tunnel(CHUNK_VOLUME);
+
+	const float originX = static_cast<float>(pos.x * Chunk::CHUNK_WIDTH);
+	const float originY = static_cast<float>(bottom);
+	const float originZ = static_cast<float>(pos.z * Chunk::CHUNK_DEPTH);
+
+	m_caveNoise.fill3D(cave.data(), originX, originY, originZ,
+	                   Chunk::CHUNK_WIDTH, Chunk::CHUNK_HEIGHT,
+	                   Chunk::CHUNK_DEPTH, CAVE_FREQUENCY);
+	m_tunnelNoise.fill3D(tunnel.data(), originX, originY, originZ,
+	                     Chunk::CHUNK_WIDTH, Chunk::CHUNK_HEIGHT,
+	                     Chunk::CHUNK_DEPTH, CAVE_FREQUENCY);
+
+	BlockType* air = BlockRegistry::get()->getFromRegistryID(m_air);
+
+	for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+	{
+		for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+		{
+			const int i    = x + Chunk::CHUNK_WIDTH * z;
+			const int soil = column.height[i] - column.soilDepth[i];
+
+			const int top = std::min(soil - bottom, Chunk::CHUNK_HEIGHT - 1);
+			for (int y = 0; y <= top; ++y)
+			{
+				const BlockPos    local(x, y, z);
+				const std::size_t index = Chunk::getVectorIndex(local);
+
+				// where two fields are both near zero is a line through
+				// space, which makes for winding tunnels.
+				if (std::abs(cave[index]) < CAVE_THICKNESS &&
+				    std::abs(tunnel[index]) < CAVE_THICKNESS)
+				{
+					chunk.setBlockAt(local, air);
+				}
+			}
+		}
+	}
+}
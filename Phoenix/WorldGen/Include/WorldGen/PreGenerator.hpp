@@ -0,0 +1,153 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <Common/Voxels/ChunkScheduler.hpp>
+#include <Common/Voxels/ChunkStore.hpp>
+#include <Common/Voxels/WorldGenerator.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace phx::worldgen
+{
+	/**
+	 * @brief How a PreGenerator run went.
+	 */
+	struct PreGeneratorStats
+	{
+		/// @brief The chunks generated and written.
+		std::size_t chunks = 0;
+		/// @brief The chunks that were already saved, and were skipped.
+		std::size_t savedChunks = 0;
+		/// @brief The chunks that couldn't be generated, and were skipped.
+		std::size_t failedChunks = 0;
+		/// @brief Whether any of the chunks couldn't be written.
+		bool failed = false;
+
+		/// @brief The time from the first request to the last chunk being
+		/// on disk.
+		std::chrono::nanoseconds total {0};
+		/// @brief The time spent waiting for chunks to be written, either
+		/// to keep the write queue short or at the end.
+		std::chrono::nanoseconds writing {0};
+		/// @brief The most chunks waiting to be written at once.
+		std::size_t peakQueued = 0;
+	};
+
+	/**
+	 * @brief Generates an area of a map ahead of time and saves it, without
+	 * a client.
+	 *
+	 * Chunks are generated with the same seed and generator as Map uses, on
+	 * a pool of worker threads, and written to the map's region files. A
+	 * map opened afterwards loads them rather than generating them.
+	 *
+	 * Only a bounded amount of chunks are requested at once, and the writes
+	 * are waited on whenever too many queue up, so the memory used doesn't
+	 * depend on the size of the area.
+	 *
+	 * The block registry has to be filled (by loading the save's mods)
+	 * before constructing this, see WorldGenerator.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * PreGenerator generator("save1", "map1", 8);
+	 *
+	 * auto stats = generator.generate(ChunkPos(0, 0, 0), 16, -4, 3, {});
+	 * @endcode
+	 */
+	class PreGenerator
+	{
+	public:
+		/// @brief Called with how many chunks are done, out of how many.
+		using Progress = std::function<void(std::size_t, std::size_t)>;
+
+		/**
+		 * @brief Opens a map to generate chunks for.
+		 * @param save The name of the save the map is in.
+		 * @param name The name of the map.
+		 * @param threads How many worker threads to generate chunks on.
+		 */
+		PreGenerator(const std::string& save, const std::string& name,
+		             std::size_t threads);
+
+		/**
+		 * @brief Generates and saves every chunk in a cylinder.
+		 * @param center The chunk the area is centered on horizontally, its
+		 * y is ignored.
+		 * @param radius The radius of the area, in chunks.
+		 * @param bottom The lowest layer of chunks to generate.
+		 * @param top The highest layer of chunks to generate.
+		 * @param progress Called every so often, can be empty.
+		 * @return How the run went.
+		 *
+		 * Chunks are done nearest the center first, so an interrupted run
+		 * still leaves the middle of the area done. Chunks that are already
+		 * saved are skipped, so running again carries on where it left off.
+		 */
+		PreGeneratorStats generate(const voxels::ChunkPos& center,
+		                           int radius, int bottom, int top,
+		                           const Progress& progress);
+
+		/**
+		 * @brief Gets how much the generator has done, and how long each
+		 * stage took.
+		 * @return The stats of the world generator.
+		 */
+		voxels::WorldGeneratorStats getGeneratorStats() const
+		{
+			return m_generator.getStats();
+		}
+
+		/**
+		 * @brief Gets the seed the map is generated from.
+		 * @return The seed of the map.
+		 */
+		std::uint32_t getSeed() const { return m_generator.getSeed(); }
+
+		/// @brief The most chunks requested from the workers at once, per
+		/// worker.
+		static constexpr std::size_t REQUESTS_PER_THREAD = 32;
+
+		/// @brief The most chunks left waiting to be written before the
+		/// writes are waited on.
+		static constexpr std::size_t MAX_QUEUED_WRITES = 4096;
+
+	private:
+		// declared in this order so the workers stop before the store and
+		// generator they use are destroyed.
+		voxels::ChunkStore     m_store;
+		voxels::WorldGenerator m_generator;
+		voxels::ChunkScheduler m_scheduler;
+
+		std::size_t m_threads;
+	};
+} // namespace phx::worldgen
@@ -0,0 +1,352 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <WorldGen/PreGenerator.hpp>
+
+#include <Common/CMS/ModManager.hpp>
+#include <Common/Logger.hpp>
+#include <Common/Settings.hpp>
+#include <Common/Voxels/BlockRegistry.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#	include <Windows.h>
+#	include <Psapi.h>
+#else
+#	include <sys/resource.h>
+#endif
+
+using namespace phx;
+
+namespace
+{
+	struct Options
+	{
+		std::string save    = "save1";
+		std::string map     = "map1";
+		int         radius  = 16;
+		int         centerX = 0;
+		int         centerZ = 0;
+		int         bottom  = -4;
+		int         top     = 3;
+		std::size_t threads = 0;
+	};
+
+	void printUsage()
+	{
+		std::cout
+		    << "Usage: PhoenixWorldGen [options]\n"
+		       "Generates the chunks around a point of a map and saves them.\n"
+		       "\n"
+		       "  --save <name>      The save to generate in (save1).\n"
+		       "  --map <name>       The map in the save (map1).\n"
+		       "  --radius <chunks>  The radius of the area (16).\n"
+		       "  --center <x> <z>   The chunk in the middle of the area (0 "
+		       "0).\n"
+		       "  --bottom <y>       The lowest layer of chunks (-4).\n"
+		       "  --top <y>          The highest layer of chunks (3).\n"
+		       "  --threads <n>      The worker threads (every core).\n";
+	}
+
+	// reads the options, returning false if they're not understood.
+	bool parseOptions(int argc, char** argv, Options& options)
+	{
+		const auto readInt = [&](int& i, int& out) {
+			if (++i >= argc)
+				return false;
+
+			char*      end   = nullptr;
+			const long value = std::strtol(argv[i], &end, 10);
+			out              = static_cast<int>(value);
+			return *end == '\0';
+		};
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string option = argv[i];
+
+			bool ok = true;
+			if (option == "--save" && i + 1 < argc)
+			{
+				options.save = argv[++i];
+			}
+			else if (option == "--map" && i + 1 < argc)
+			{
+				options.map = argv[++i];
+			}
+			else if (option == "--radius")
+			{
+				ok = readInt(i, options.radius) && options.radius >= 0;
+			}
+			else if (option == "--center")
+			{
+				ok = readInt(i, options.centerX) && readInt(i, options.centerZ);
+			}
+			else if (option == "--bottom")
+			{
+				ok = readInt(i, options.bottom);
+			}
+			else if (option == "--top")
+			{
+				ok = readInt(i, options.top);
+			}
+			else if (option == "--threads")
+			{
+				int threads     = 0;
+				ok              = readInt(i, threads) && threads > 0;
+				options.threads = static_cast<std::size_t>(threads);
+			}
+			else
+			{
+				ok = false;
+			}
+
+			if (!ok)
+			{
+				std::cerr << "Unrecognised option: " << option << "\n";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// mods call these while loading, but there's nothing to do with them
+	// here.
+	void registerUnusedAPI(cms::ModManager* manager)
+	{
+		manager->registerFunction("core.input.registerInput",
+		                          [](std::string /*uniqueName*/,
+		                             std::string /*displayName*/,
+		                             std::string /*defaultKey*/) {});
+		manager->registerFunction("core.input.getInput", [](int /*input*/) {});
+		manager->registerFunction("core.input.getInputRef",
+		                          [](std::string /*uniqueName*/) {});
+		manager->registerFunction("core.input.registerCallback",
+		                          [](int /*input*/, sol::function /*f*/) {});
+		manager->registerFunction("core.command.register",
+		                          [](std::string /*command*/,
+		                             std::string /*help*/,
+		                             sol::function /*f*/) {});
+		manager->registerFunction("audio.loadMP3",
+		                          [](const std::string& /*uniqueName*/,
+		                             const std::string& /*filePath*/) {
+			                          return 0;
+		                          });
+		manager->registerFunction("audio.play",
+		                          [](sol::table /*source*/) {});
+	}
+
+	// loads the save's mods, which register the blocks the world is made of.
+	std::unique_ptr<cms::ModManager> loadMods(const std::string& save)
+	{
+		std::ifstream file("Saves/" + save + "/Mods.txt");
+		if (!file.is_open())
+		{
+			LOG_FATAL("CMS") << "Error opening save file: \"Saves/" + save +
+			                        "/Mods.txt\"";
+			return nullptr;
+		}
+
+		std::vector<std::string> toLoad;
+		std::string              mod;
+		while (std::getline(file, mod))
+		{
+			toLoad.push_back(mod);
+		}
+
+		auto manager = std::make_unique<cms::ModManager>(
+		    toLoad, cms::ModManager::ModList {"Modules"});
+
+		voxels::BlockRegistry::get()->registerAPI(manager.get());
+		Settings::get()->registerAPI(manager.get());
+
+		manager->registerFunction("core.print", [](const std::string& text) {
+			std::cout << text << "\n";
+		});
+		manager->registerFunction("core.log_warning", [](std::string message) {
+			LOG_WARNING("MODULE") << message;
+		});
+		manager->registerFunction("core.log_fatal", [](std::string message) {
+			LOG_FATAL("MODULE") << message;
+		});
+		manager->registerFunction("core.log_info", [](std::string message) {
+			LOG_INFO("MODULE") << message;
+		});
+		manager->registerFunction("core.log_debug", [](std::string message) {
+			LOG_DEBUG("MODULE") << message;
+		});
+
+		registerUnusedAPI(manager.get());
+
+		float progress = 0.f;
+		if (!manager->load(&progress).ok)
+		{
+			LOG_FATAL("CMS") << "An error has occurred loading modules.";
+			return nullptr;
+		}
+
+		return manager;
+	}
+
+	// the most memory the process has had resident, in bytes.
+	std::size_t getPeakMemory()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize;
+#else
+		rusage usage {};
+		getrusage(RUSAGE_SELF, &usage);
+#	if defined(__APPLE__)
+		return static_cast<std::size_t>(usage.ru_maxrss);
+#	else
+		return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#	endif
+#endif
+	}
+
+	double toMilliseconds(std::chrono::nanoseconds time)
+	{
+		return std::chrono::duration<double, std::milli>(time).count();
+	}
+} // namespace
+
+#undef main
+int main(int argc, char** argv)
+{
+	using Clock = std::chrono::steady_clock;
+
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (options.threads == 0)
+	{
+		options.threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	Logger::initialize({});
+
+	const Clock::time_point modStart = Clock::now();
+	const auto              mods     = loadMods(options.save);
+	if (mods == nullptr)
+	{
+		Logger::teardown();
+		return EXIT_FAILURE;
+	}
+
+	const auto modTime = Clock::now() - modStart;
+
+	worldgen::PreGenerator generator(options.save, options.map,
+	                                 options.threads);
+
+	std::cout << "Generating \"" << options.save << "/" << options.map
+	          << "\" (seed " << generator.getSeed() << "), radius "
+	          << options.radius << " around " << options.centerX << ", "
+	          << options.centerZ << ", layers " << options.bottom << " to "
+	          << options.top << ", on " << options.threads << " threads.\n";
+
+	// progress is only printed every so often, it's reported every batch.
+	Clock::time_point lastReport = Clock::now();
+	const auto progress = [&lastReport](std::size_t done, std::size_t total) {
+		if (Clock::now() - lastReport < std::chrono::seconds(1))
+			return;
+
+		lastReport = Clock::now();
+		std::printf("  %zu / %zu chunks\n", done, total);
+		std::fflush(stdout);
+	};
+
+	const worldgen::PreGeneratorStats stats = generator.generate(
+	    voxels::ChunkPos(options.centerX, 0, options.centerZ), options.radius,
+	    options.bottom, options.top, progress);
+
+	const voxels::WorldGeneratorStats stages = generator.getGeneratorStats();
+
+	const double seconds = std::chrono::duration<double>(stats.total).count();
+
+	std::printf("Saved %zu chunks in %.2f s: %.0f chunks/s.\n", stats.chunks,
+	            seconds, seconds > 0.0 ? stats.chunks / seconds : 0.0);
+	if (stats.savedChunks != 0)
+	{
+		std::printf("Skipped %zu chunks that were already saved.\n",
+		            stats.savedChunks);
+	}
+
+	std::printf("Peak memory: %.1f MiB.\n",
+	            getPeakMemory() / (1024.0 * 1024.0));
+	std::printf("Stages (wall time):\n");
+	std::printf("  loading mods  %10.1f ms\n", toMilliseconds(modTime));
+	std::printf("  generating    %10.1f ms (including waiting on chunks)\n",
+	            toMilliseconds(stats.total - stats.writing));
+	std::printf("  writing       %10.1f ms (at most %zu chunks queued)\n",
+	            toMilliseconds(stats.writing), stats.peakQueued);
+	std::printf("Generator stages (summed over %zu threads):\n",
+	            options.threads);
+	std::printf("  heightmap     %10.1f ms (%zu columns built)\n",
+	            toMilliseconds(stages.heightmap), stages.columns);
+	std::printf("  surface       %10.1f ms\n", toMilliseconds(stages.surface));
+	std::printf("  caves         %10.1f ms\n", toMilliseconds(stages.caves));
+	std::printf("  %zu chunks generated, %zu of them above the ground.\n",
+	            stages.chunks, stages.emptyChunks);
+
+	if (stats.failedChunks != 0)
+	{
+		LOG_FATAL("WORLDGEN") << stats.failedChunks
+		                      << " chunks couldn't be generated.";
+	}
+
+	if (stats.failed)
+	{
+		LOG_FATAL("WORLDGEN") << "Some chunks couldn't be written to disk.";
+	}
+
+	if (stats.failed || stats.failedChunks != 0)
+	{
+		Logger::teardown();
+		return EXIT_FAILURE;
+	}
+
+	Logger::teardown();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <WorldGen/PreGenerator.hpp>
+
+#include <Common/Voxels/Map.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <vector>
+
+using namespace phx::worldgen;
+using namespace phx;
+
+PreGenerator::PreGenerator(const std::string& save, const std::string& name,
+                           std::size_t threads)
+    : m_store("Saves/" + save, name),
+      m_generator(voxels::Map::loadSeed(save, name)),
+      m_scheduler(threads, m_store, m_generator),
+      m_threads(std::max<std::size_t>(threads, 1))
+{
+}
+
+PreGeneratorStats PreGenerator::generate(const voxels::ChunkPos& center,
+                                         int radius, int bottom, int top,
+                                         const Progress& progress)
+{
+	using Clock = std::chrono::steady_clock;
+
+	PreGeneratorStats stats;
+	const Clock::time_point start = Clock::now();
+
+	// the columns of the area, nearest the center first.
+	std::vector<voxels::ChunkPos> columns;
+	for (int x = -radius; x <= radius; ++x)
+	{
+		for (int z = -radius; z <= radius; ++z)
+		{
+			if (x * x + z * z <= radius * radius)
+			{
+				columns.emplace_back(x, 0, z);
+			}
+		}
+	}
+
+	std::stable_sort(
+	    columns.begin(), columns.end(),
+	    [](const voxels::ChunkPos& lhs, const voxels::ChunkPos& rhs) {
+		    return lhs.x * lhs.x + lhs.z * lhs.z <
+		           rhs.x * rhs.x + rhs.z * rhs.z;
+	    });
+
+	std::vector<voxels::ChunkPos> area;
+	area.reserve(columns.size() *
+	             static_cast<std::size_t>(std::max(top - bottom + 1, 0)));
+	for (const voxels::ChunkPos& column : columns)
+	{
+		for (int y = bottom; y <= top; ++y)
+		{
+			area.emplace_back(center.x + column.x, y, center.z + column.z);
+		}
+	}
+
+	const std::size_t maxRequests = m_threads * REQUESTS_PER_THREAD;
+
+	std::deque<voxels::ChunkScheduler::Result> requests;
+	std::vector<voxels::ChunkSnapshot>         finished;
+	std::vector<voxels::ChunkPos>              failed;
+	std::size_t                                next = 0;
+
+	const auto isReady = [](const voxels::ChunkScheduler::Result& result) {
+		return result.wait_for(std::chrono::seconds(0)) ==
+		       std::future_status::ready;
+	};
+
+	while (stats.chunks + stats.savedChunks + stats.failedChunks <
+	       area.size())
+	{
+		// keeps the workers busy without requesting the whole area at once.
+		while (next < area.size() && requests.size() < maxRequests)
+		{
+			// chunks that are already saved are left as they are.
+			if (m_store.contains(area[next]))
+			{
+				++stats.savedChunks;
+				++next;
+				continue;
+			}
+
+			requests.push_back(m_scheduler.request(area[next++]));
+		}
+
+		finished.clear();
+		failed.clear();
+		m_scheduler.collect(finished, &failed);
+
+		for (const voxels::ChunkSnapshot& snapshot : finished)
+		{
+			m_store.store(snapshot->getChunkPos(), snapshot->save());
+		}
+
+		stats.chunks       += finished.size();
+		stats.failedChunks += failed.size();
+
+		const std::size_t queued = m_store.getPendingCount();
+		stats.peakQueued         = std::max(stats.peakQueued, queued);
+
+		// generating is usually faster than writing, so the queued payloads
+		// would pile up without this.
+		if (queued > MAX_QUEUED_WRITES)
+		{
+			const Clock::time_point waited = Clock::now();
+			stats.failed |= !m_store.flush();
+			stats.writing += Clock::now() - waited;
+		}
+
+		if (progress)
+		{
+			progress(stats.chunks + stats.savedChunks, area.size());
+		}
+
+		// the workers take requests in order, so the oldest is usually the
+		// next to finish.
+		while (!requests.empty() && isReady(requests.front()))
+		{
+			requests.pop_front();
+		}
+
+		if (finished.empty() && failed.empty() && !requests.empty())
+		{
+			requests.front().wait();
+		}
+	}
+
+	const Clock::time_point waited = Clock::now();
+	stats.failed |= !m_store.flush();
+	stats.writing += Clock::now() - waited;
+
+	stats.total = Clock::now() - start;
+	return stats;
+}